@@ -0,0 +1,153 @@
+#include "hashtab.h"
+
+#include <stdlib.h>
+
+/**
+ * __htab_index() - bucket of hash in table of 2^bits buckets
+ *
+ * Hash is multiplied by golden ratio and top bits are taken, so weak hashes
+ * (e.g. identity on integers) are spread too.
+ */
+static inline size_t __htab_index(uint64_t hash, unsigned bits)
+{
+    return (hash * 0x9E3779B97F4A7C15ULL) >> (64 - bits);
+}
+
+/**
+ * __htab_alloc() - empty table of 2^bits buckets
+ *
+ * Empty bucket is NULL pointer, so calloc() is enough. Big tables get fresh
+ * zero pages from kernel, so there is no O(n) initialization on resize.
+ */
+static struct hlist_head *__htab_alloc(unsigned bits)
+{
+    return calloc((size_t)1 << bits, sizeof(struct hlist_head));
+}
+
+/**
+ * __htab_bucket() - bucket of current table for key
+ */
+static inline struct hlist_head *__htab_bucket(const struct htab *ht, const void *key)
+{
+    return &ht->buckets[__htab_index(ht->ops->hash(key), ht->bits)];
+}
+
+/**
+ * __htab_migrate() - move up to num old buckets to current table
+ */
+static void __htab_migrate(struct htab *ht, size_t num)
+{
+    size_t old_size = (size_t)1 << ht->old_bits;
+    struct hlist_node *temp, *safe;
+
+    for(; num && ht->moved < old_size; num--, ht->moved++) {
+        hlist_for_each_safe(temp, safe, &ht->old[ht->moved]) {
+            hlist_del(temp);
+            hlist_add_head(__htab_bucket(ht, ht->ops->key(temp)), temp);
+        }
+    }
+    if(ht->moved == old_size) {
+        free(ht->old);
+        ht->old = NULL;
+    }
+}
+
+/**
+ * __htab_resize() - start moving nodes to table of 2^bits buckets
+ *
+ * Previous resize is finished first. On allocation failure nothing changes.
+ */
+static void __htab_resize(struct htab *ht, unsigned bits)
+{
+    struct hlist_head *buckets;
+
+    if(ht->old)
+        __htab_migrate(ht, (size_t)1 << ht->old_bits);
+    buckets = __htab_alloc(bits);
+    if(!buckets)
+        return;
+    ht->old = ht->buckets;
+    ht->old_bits = ht->bits;
+    ht->moved = 0;
+    ht->buckets = buckets;
+    ht->bits = bits;
+}
+
+enum errors htab_init(struct htab *ht, const struct htab_ops *ops, unsigned bits)
+{
+    if(bits < HTAB_MIN_BITS)
+        bits = HTAB_MIN_BITS;
+    ht->buckets = __htab_alloc(bits);
+    if(!ht->buckets)
+        return NO_MEMORY;
+    ht->bits = bits;
+    ht->old = NULL;
+    ht->old_bits = 0;
+    ht->moved = 0;
+    ht->size = 0;
+    ht->ops = ops;
+    return OK;
+}
+
+void htab_free(struct htab *ht)
+{
+    free(ht->old);
+    free(ht->buckets);
+    ht->old = ht->buckets = NULL;
+}
+
+void htab_insert(struct htab *ht, struct hlist_node *node)
+{
+    if(ht->old)
+        __htab_migrate(ht, HTAB_MIGRATE);
+    else if(ht->size >= (size_t)1 << ht->bits)
+        __htab_resize(ht, ht->bits + 1);
+    hlist_add_head(__htab_bucket(ht, ht->ops->key(node)), node);
+    ++ht->size;
+}
+
+void htab_delete(struct htab *ht, struct hlist_node *node)
+{
+    //node knows its place, so it doesn't matter which table it is in
+    hlist_del(node);
+    --ht->size;
+    //shrinking table has 2 times more old buckets and 8 times less nodes,
+    //so it is moved faster to finish before table is empty
+    if(ht->old)
+        __htab_migrate(ht, ht->old_bits > ht->bits ? 4 * HTAB_MIGRATE : HTAB_MIGRATE);
+    else if(ht->bits > HTAB_MIN_BITS && ht->size < ((size_t)1 << ht->bits) / 8)
+        __htab_resize(ht, ht->bits - 1);
+}
+
+struct hlist_node *htab_find(const struct htab *ht, const void *key)
+{
+    uint64_t hash = ht->ops->hash(key);
+    struct hlist_head *head = &ht->buckets[__htab_index(hash, ht->bits)];
+    struct hlist_node *temp;
+
+    hlist_for_each(temp, head)
+        if(ht->ops->equal(key, ht->ops->key(temp)))
+            return temp;
+    if(ht->old) {
+        size_t i = __htab_index(hash, ht->old_bits);
+        //moved buckets are empty, nothing to check there
+        if(i >= ht->moved)
+            hlist_for_each(temp, &ht->old[i])
+                if(ht->ops->equal(key, ht->ops->key(temp)))
+                    return temp;
+    }
+    return NULL;
+}
+
+void htab_traverse(const struct htab *ht, void (*func)(struct hlist_node *node))
+{
+    struct hlist_node *temp;
+
+    for(size_t i = 0; i < (size_t)1 << ht->bits; i++)
+        hlist_for_each(temp, &ht->buckets[i])
+            func(temp);
+    if(ht->old)
+        for(size_t i = ht->moved; i < (size_t)1 << ht->old_bits; i++)
+            hlist_for_each(temp, &ht->old[i])
+                func(temp);
+}
@@ -0,0 +1,117 @@
+#ifndef HASHTAB_H
+#define HASHTAB_H
+
+#include "list.h"
+
+/**
+ * HTAB_MIGRATE - number of old buckets moved to new table by every insert or
+ * delete while table is resized
+ */
+#define HTAB_MIGRATE 4
+
+/**
+ * HTAB_MIN_BITS - table never has less than 2^HTAB_MIN_BITS buckets
+ */
+#define HTAB_MIN_BITS 3
+
+/**
+ * struct htab_ops - user callbacks of hash table
+ * @hash: hash of key
+ * @key: key of node. Node is the one embedded into parent struct, use list_entry()
+ * @equal: true if keys are equal
+ */
+struct htab_ops {
+    uint64_t (*hash)(const void *key);
+    const void *(*key)(struct hlist_node *node);
+    bool (*equal)(const void *key1, const void *key2);
+};
+
+/**
+ * struct htab - intrusive hash table with hlist buckets and incremental resize
+ * @buckets: current table, 2^bits buckets
+ * @bits: log2 of number of buckets
+ * @old: previous table while it is being moved to current one, NULL otherwise
+ * @old_bits: log2 of number of buckets of old
+ * @moved: buckets of old, which are already moved
+ * @size: number of nodes
+ * @ops: callbacks
+ *
+ * Nodes are struct hlist_node, embedded into data struct, so object can sit on
+ * usual lists and in hash table at the same time. Table doubles when there are
+ * more nodes than buckets and halves when there are 8 times less. Nodes are not
+ * rehashed at once: every insert and delete moves HTAB_MIGRATE old buckets, lookups
+ * check both tables till old one is empty. So there is no long pause on resize.
+ */
+struct htab {
+    struct hlist_head *buckets;
+    unsigned bits;
+    struct hlist_head *old;
+    unsigned old_bits;
+    size_t moved;
+    size_t size;
+    const struct htab_ops *ops;
+};
+
+/**
+ * htab_init() - create empty table
+ * @ht: pointer to table
+ * @ops: callbacks. Must live as long as table
+ * @bits: log2 of initial number of buckets
+ *
+ * Only bucket arrays are allocated, nodes are never allocated nor freed.
+ *
+ * Return:
+ * * OK - created
+ * * NO_MEMORY - allocation of buckets failed
+ */
+enum errors htab_init(struct htab *ht, const struct htab_ops *ops, unsigned bits);
+
+/**
+ * htab_free() - free bucket arrays. Nodes are left untouched
+ * @ht: pointer to table
+ */
+void htab_free(struct htab *ht);
+
+/**
+ * htab_size() - number of nodes in O(1)
+ * @ht: pointer to table
+ */
+static inline size_t htab_size(const struct htab *ht)
+{
+    return ht->size;
+}
+
+/**
+ * htab_insert() - add node in O(1). Equal keys are allowed
+ * @ht: pointer to table
+ * @node: pointer to node to be added
+ *
+ * If bigger table can't be allocated, table is not resized and just gets
+ * longer buckets.
+ */
+void htab_insert(struct htab *ht, struct hlist_node *node);
+
+/**
+ * htab_delete() - remove node from table in O(1)
+ * @ht: pointer to table, which contains node
+ * @node: pointer to node to be removed
+ */
+void htab_delete(struct htab *ht, struct hlist_node *node);
+
+/**
+ * htab_find() - find node by key in O(1)
+ * @ht: pointer to table
+ * @key: key to find
+ *
+ * Return: node with equal key or NULL. If there are several, any of them.
+ */
+struct hlist_node *htab_find(const struct htab *ht, const void *key);
+
+/**
+ * htab_traverse() - call func for every node. Order is unspecified
+ * @ht: pointer to table
+ * @func: function to be called for every node. Can't modify table
+ */
+void htab_traverse(const struct htab *ht, void (*func)(struct hlist_node *node));
+
+#endif /* HASHTAB_H */
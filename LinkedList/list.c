@@ -2,6 +2,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdlib.h>
 
 enum errors insert_n_check(struct list *list, struct list *elem, int n)
 {
@@ -57,6 +58,41 @@ void clear_all(struct list *list)
     INIT_LIST(list);
 }
 
+#ifdef DEBUG
+/**
+ * __poison_range() - poison pointers of nodes in bounds [from; to]
+ */
+static void __poison_range(struct list *from, struct list *to)
+{
+    struct list *temp, *next;
+    for(temp = from; ; temp = next) {
+        next = temp->next;
+        temp->next = LIST_POISON_NEXT;
+        temp->prev = LIST_POISON_PREV;
+        if(temp == to) break;
+    }
+}
+#endif
+
+void clear_detach(struct list *from, struct list *to)
+{
+    if(from == to) return;
+    from->prev->next = to->next;
+    to->next->prev = from->prev;
+#ifdef DEBUG
+    __poison_range(from, to);
+#endif
+}
+
+void clear_all_detach(struct list *list)
+{
+#ifdef DEBUG
+    if(list->next != list)
+        __poison_range(list->next, list->prev);
+#endif
+    INIT_LIST(list);
+}
+
 /**
  * __swap() - custom swap pointer values without 3-rd variable
  * @x: first value to swap
@@ -128,50 +164,201 @@ int count(struct list *list, void *val, int (*comp)(void *val, struct list *el2)
 }
 
 /**
- * Implements partition of quicksort
+ * __sort_cmp() - adapter of user comparator to __list_sort()
+ * @ctx: pointer to comparator passed to sort()
  */
-static struct list * __qs_partition(struct list **lo, struct list **hi, int (*comp)(struct list *el1, struct list *el2))
-{
-    struct list *pivot = *hi;
-    struct list *i = (*lo)->prev;
-    struct list *j;
-
-    list_for_each_bounds(j,*lo,*hi) {
-        if(comp(j, pivot) <= 0)
-        {
-            i = i->next;
-            if(i == *lo)
-                *lo = j;
-            swap_list(i,j);
-            __swap(&i, &j);
+static int __sort_cmp(struct list *el1, struct list *el2, const void *ctx)
+{
+    int (* const *comp)(struct list *el1, struct list *el2) = ctx;
+    return (*comp)(el1, el2);
+}
+
+void sort(struct list *list, int (*comp)(struct list *el1, struct list *el2), bool order)
+{
+    __list_sort(list, __sort_cmp, &comp, order);
+}
+
+
+/* Internal pool of keys for sort_by_key(), grows on demand */
+static struct list_key *__key_pool = NULL;
+static size_t __key_pool_size = 0;
+
+/**
+ * __key_pool_grow() - make internal pool at least size elements big
+ */
+static bool __key_pool_grow(size_t size)
+{
+    size_t new_size = __key_pool_size ? __key_pool_size : 64;
+    struct list_key *temp;
+
+    while(new_size < size)
+        new_size *= 2;
+    temp = realloc(__key_pool, new_size * sizeof(*temp));
+    if(!temp) return false;
+    __key_pool = temp;
+    __key_pool_size = new_size;
+    return true;
+}
+
+void sort_by_key_free(void)
+{
+    free(__key_pool);
+    __key_pool = NULL;
+    __key_pool_size = 0;
+}
+
+/**
+ * __radix_key() - convert signed key to unsigned one with the needed order
+ *
+ * Flipping sign bit makes unsigned order equal to signed one. Inverting all bits
+ * gives descending order while equal keys stay equal, so sort stays stable.
+ */
+static inline uint64_t __radix_key(int64_t key, bool order)
+{
+    uint64_t res = (uint64_t)key ^ ((uint64_t)1 << 63);
+    return order ? res : ~res;
+}
+
+/**
+ * __radix_sort() - LSD radix sort of keys, one byte per pass
+ * @src: keys to be sorted
+ * @dst: temporary storage of the same size
+ * @n: number of keys
+ *
+ * Histograms of all bytes are built in one pass. Passes, where all keys have
+ * the same byte, are skipped, so small keys cost only few passes.
+ *
+ * Return: pointer to sorted keys (either src or dst)
+ */
+static struct list_key * __radix_sort(struct list_key *src, struct list_key *dst, size_t n)
+{
+    size_t hist[sizeof(uint64_t)][256] = {{0}};
+    struct list_key *temp;
+    size_t i, sum, cnt;
+    unsigned int byte, shift;
+
+    for(i = 0; i < n; ++i) {
+        for(byte = 0; byte < sizeof(uint64_t); ++byte)
+            ++hist[byte][(src[i].key >> (byte * 8)) & 0xFF];
+    }
+
+    for(byte = 0; byte < sizeof(uint64_t); ++byte) {
+        shift = byte * 8;
+        if(hist[byte][(src[0].key >> shift) & 0xFF] == n) continue;
+
+        for(i = 0, sum = 0; i < 256; ++i) {
+            cnt = hist[byte][i];
+            hist[byte][i] = sum;
+            sum += cnt;
+        }
+        for(i = 0; i < n; ++i)
+            dst[hist[byte][(src[i].key >> shift) & 0xFF]++] = src[i];
+
+        temp = src;
+        src = dst;
+        dst = temp;
+    }
+    return src;
+}
+
+enum errors sort_by_key(struct list *list, int64_t (*key)(struct list *elem), bool order,
+                        struct list_key *buf, size_t buf_size)
+{
+    bool pooled = !buf;
+    struct list *temp, *prev;
+    size_t n = 0, i;
+
+    if(pooled) {
+        buf = __key_pool;
+        buf_size = __key_pool_size;
+    }
+
+    list_for_each(temp, list) {
+        if(2 * (n + 1) > buf_size) {
+            if(!pooled) return BUFFER_TOO_SMALL;
+            if(!__key_pool_grow(2 * (n + 1))) return NO_MEMORY;
+            buf = __key_pool;
+            buf_size = __key_pool_size;
         }
+        buf[n].key = __radix_key(key(temp), order);
+        buf[n].node = temp;
+        ++n;
+    }
+    if(n < 2) return OK;
+
+    buf = __radix_sort(buf, buf + n, n);
+
+    prev = list;
+    for(i = 0; i < n; ++i) {
+        prev->next = buf[i].node;
+        buf[i].node->prev = prev;
+        prev = buf[i].node;
     }
-    i = i->next;
-    
-    *hi = i;
-    if(i == *lo)
-        *lo = pivot;
-        
-    swap_list(i, pivot);
-    return pivot;
+    prev->next = list;
+    list->prev = prev;
+    return OK;
 }
 
 /**
- * Main sorting function of quicksort
+ * __clist_node() - get node at position pos of counted list, walking from the closest end
+ * @cl: pointer to counted list
+ * @pos: position in [0; size]. Position size is the list head itself
  */
-static void __qsort(struct list *list, struct list *lo, struct list *hi, int (*comp)(struct list *el1, struct list *el2))
+static struct list * __clist_node(struct clist *cl, int pos)
 {
-    if(lo != hi && hi->next != lo && lo->prev != hi)
-    {
-        struct list *pi = __qs_partition(&lo, &hi, comp);
-        
-        __qsort(list, lo, pi->prev, comp);
-        __qsort(list, pi->next, hi, comp);
+    struct list *temp;
+    int steps;
+
+    if(pos <= cl->size / 2) {
+        for(temp = cl->list.next; pos > 0; --pos)
+            temp = temp->next;
+    } else {
+        for(temp = &cl->list, steps = cl->size - pos; steps > 0; --steps)
+            temp = temp->prev;
     }
+    return temp;
 }
 
-void sort(struct list *list, int (*comp)(struct list *el1, struct list *el2), bool order)
+enum errors clist_insert_n(struct clist *cl, struct list *elem, int n)
+{
+    if(n < 0)
+        n += cl->size + 1;
+    if(n < 0 || n > cl->size)
+        return INDEX_OUT_OF_BOUNDS;
+    clist_insert_before(cl, __clist_node(cl, n), elem);
+    return OK;
+}
+
+struct list *clist_get_n(struct clist *cl, int n)
+{
+    if(n < 0)
+        n += cl->size;
+    if(n < 0 || n >= cl->size)
+        return NULL;
+    return __clist_node(cl, n);
+}
+
+struct list *clist_delete_n(struct clist *cl, int n)
+{
+    struct list *temp = clist_get_n(cl, n);
+    if(temp)
+        clist_delete_list_entry(cl, temp);
+    return temp;
+}
+
+void clist_clear(struct clist *cl, struct list *from, struct list *to)
+{
+    struct list *temp;
+    if(from == to) return;
+    list_for_each_bounds(temp, from->next, to->next) {
+        if(temp->prev == &cl->list) continue;
+        clist_delete_list_entry(cl, temp->prev);
+    }
+    clist_delete_list_entry(cl, to);
+}
+
+void clist_clear_all(struct clist *cl)
 {
-    __qsort(list, list->next, list->prev, comp);
-    if(!order) reverse(list);
-}
\ No newline at end of file
+    clear_all(&cl->list);
+    cl->size = 0;
+}
@@ -1,16 +1,24 @@
+#ifndef LIST_H
+#define LIST_H
+
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 /**
  * enum errors - errors
  * @OK: no errors
  * @INDEX_OUT_OF_BOUNDS: index out of bounds
+ * @BUFFER_TOO_SMALL: buffer given by user can't hold all elements
+ * @NO_MEMORY: internal allocation failed
  *
- * Now they used only in insert_n_check() method.
+ * Now they used only in insert_n_check() and sort_by_key() methods.
  */
 enum errors {
     OK=0,
-    INDEX_OUT_OF_BOUNDS
+    INDEX_OUT_OF_BOUNDS,
+    BUFFER_TOO_SMALL,
+    NO_MEMORY
 };
 
 /**
@@ -22,6 +30,14 @@ struct list {
     struct list *prev, *next;
 };
 
+/**
+ * LIST_POISON_NEXT, LIST_POISON_PREV - values, written to pointers of detached
+ * nodes in DEBUG builds. Any access through them faults, so use of node after
+ * it was removed is caught.
+ */
+#define LIST_POISON_NEXT ((struct list *)0x100)
+#define LIST_POISON_PREV ((struct list *)0x122)
+
 /**
  * INIT_LIST(l) - Create list from existing list node
  * @l: pointer to existing node
@@ -220,6 +236,175 @@ static inline void delete_list_entry(struct list *elem)
     elem->next = elem->prev = NULL;
 }
 
+/**
+ * __list_splice() - insert all nodes of list between two consecutive nodes(prev and next)
+ * @list: pointer to parent list node of nodes to insert. Has to be non-empty
+ * @prev: pointer to node to be before first node of list
+ * @next: pointer to node to be after last node of list
+ *
+ * list itself is left untouched, so it still points to moved nodes.
+ */
+static inline void __list_splice(const struct list *list, struct list *prev, struct list *next)
+{
+    struct list *first = list->next;
+    struct list *last = list->prev;
+
+    first->prev = prev;
+    prev->next = first;
+    last->next = next;
+    next->prev = last;
+}
+
+/**
+ * list_splice() - move all nodes of list to the head of other list. O(1)
+ * @list: pointer to parent list node of nodes to move. Will be empty after operation
+ * @head: pointer to list node, after which nodes are inserted. E.g. created with CREATE_LIST
+ */
+static inline void list_splice(struct list *list, struct list *head)
+{
+    if(list->next == list) return;
+    __list_splice(list, head, head->next);
+    INIT_LIST(list);
+}
+
+/**
+ * list_splice_tail() - move all nodes of list to the tail of other list. O(1)
+ * @list: pointer to parent list node of nodes to move. Will be empty after operation
+ * @head: pointer to list node, before which nodes are inserted. E.g. created with CREATE_LIST
+ *
+ * This is "extend" operation: list_splice_tail(&b, &a) appends b to a.
+ */
+static inline void list_splice_tail(struct list *list, struct list *head)
+{
+    if(list->next == list) return;
+    __list_splice(list, head->prev, head);
+    INIT_LIST(list);
+}
+
+/**
+ * list_cut_range() - move nodes in bounds [from; to) to other list. O(1)
+ * @list: pointer to parent list node, which will contain moved nodes
+ * @from: first node to move
+ * @to: node after the last node to move. It stays in its list
+ *
+ * Moved nodes are exactly those, which list_for_each_bounds(elem, from, to) visits.
+ * Range must not contain parent node of its list. Old nodes of list are lost,
+ * so it should be empty. If from == to, list becomes empty.
+ */
+static inline void list_cut_range(struct list *list, struct list *from, struct list *to)
+{
+    struct list *last = to->prev;
+
+    if(from == to) {
+        INIT_LIST(list);
+        return;
+    }
+    from->prev->next = to;
+    to->prev = from->prev;
+    list->next = from;
+    from->prev = list;
+    list->prev = last;
+    last->next = list;
+}
+
+/**
+ * list_cut_position() - move nodes from the head of list up to entry (included) to other list. O(1)
+ * @list: pointer to parent list node, which will contain moved nodes. Should be empty
+ * @head: pointer to parent list node of nodes to move. E.g. created with CREATE_LIST
+ * @entry: last node to move. If entry is head, nothing is moved
+ */
+static inline void list_cut_position(struct list *list, struct list *head, struct list *entry)
+{
+    list_cut_range(list, head->next, entry->next);
+}
+
+/**
+ * list_next_rcu(elem) - read next pointer of node, published by *_rcu writers
+ * @elem: pointer to list node
+ *
+ * Acquire load pairs with release store in __add_elem_middle_rcu(), so the
+ * node is seen fully initialized.
+ */
+#define list_next_rcu(elem) __atomic_load_n(&(elem)->next, __ATOMIC_ACQUIRE)
+
+/**
+ * list_for_each_rcu(elem, list) - Macro for iterating list, modified concurrently by *_rcu writers
+ * @elem: pointer to current list node. Has to be pre-created as struct list *
+ * @list: pointer to parent list node. E.g. created with CREATE_LIST
+ *
+ * Has to be called inside rcu_read_lock()/rcu_read_unlock() (see rcu.h).
+ * Only forward direction is safe: prev pointers are not published to readers.
+ */
+#define list_for_each_rcu(elem, list) for(elem = list_next_rcu(list); elem != (list); \
+                                        elem = list_next_rcu(elem))
+
+/**
+ * __add_elem_middle_rcu() - Add element between two consecutive nodes, visible to rcu readers
+ * @prev: pointer to node to be before element
+ * @elem: pointer to list node to insert
+ * @next: pointer to node to be after element
+ *
+ * elem is filled first and only then published with release store, so readers
+ * never see half-initialized node.
+ */
+static inline void __add_elem_middle_rcu(struct list *prev, struct list *elem, struct list *next)
+{
+    elem->next = next;
+    elem->prev = prev;
+    __atomic_store_n(&prev->next, elem, __ATOMIC_RELEASE);
+    next->prev = elem;
+}
+
+/**
+ * insert_before_rcu() - add elem before other, while readers may traverse list
+ * @next: pointer to other element.
+ * @elem: pointer to list node to be added before next
+ *
+ * Writers have to be serialized by caller.
+ */
+static inline void insert_before_rcu(struct list *next, struct list *elem)
+{
+    __add_elem_middle_rcu(next->prev, elem, next);
+}
+
+/**
+ * insert_after_rcu() - add elem after other, while readers may traverse list
+ * @prev: pointer to other element.
+ * @elem: pointer to list node to be added after prev
+ *
+ * Writers have to be serialized by caller.
+ */
+static inline void insert_after_rcu(struct list *prev, struct list *elem)
+{
+    __add_elem_middle_rcu(prev, elem, prev->next);
+}
+
+/**
+ * add_elem_rcu() - add elem to the tail of list, while readers may traverse it
+ */
+#define add_elem_rcu(list, elem) insert_before_rcu((list), (elem))
+
+/**
+ * add_elem_head_rcu() - add elem to the head of list, while readers may traverse it
+ */
+#define add_elem_head_rcu(list, elem) insert_after_rcu((list), (elem))
+
+/**
+ * delete_list_entry_rcu() - deletes node from list, while readers may traverse it
+ * @elem: elem to be deleted
+ *
+ * Readers, which are standing on elem, still can go forward, so next pointer
+ * is kept and only prev is poisoned. elem can be reused or freed only after
+ * grace period: synchronize_rcu() or call_rcu() (see rcu.h).
+ * Writers have to be serialized by caller.
+ */
+static inline void delete_list_entry_rcu(struct list *elem)
+{
+    __atomic_store_n(&elem->prev->next, elem->next, __ATOMIC_RELEASE);
+    elem->next->prev = elem->prev;
+    elem->prev = LIST_POISON_PREV;
+}
+
 /**
  * clear() - delete list nodes in bounds [from; to]
  * @from: start node
@@ -243,6 +428,26 @@ void clear_safe(struct list *list, struct list *from, struct list *to);
  */
 void clear_all(struct list *list);
 
+/**
+ * clear_detach() - detach list nodes in bounds [from; to] in O(1)
+ * @from: start node
+ * @to: end node
+ *
+ * Unlike clear(), nodes are not touched, only neighbours of range are relinked.
+ * Pointers of detached nodes are stale and must not be used. In DEBUG builds
+ * every detached node is walked and poisoned with LIST_POISON_* values.
+ * Range must not contain parent node.
+ */
+void clear_detach(struct list *from, struct list *to);
+
+/**
+ * clear_all_detach() - detach all nodes from list in O(1)
+ * @list: pointer to parent list node. E.g. created with CREATE_LIST
+ *
+ * Same as clear_detach(), nodes are poisoned only in DEBUG builds.
+ */
+void clear_all_detach(struct list *list);
+
 /**
  * traverse() - traverse through list using custom func.
  * @list: pointer to parent list node. E.g. created with CREATE_LIST
@@ -295,5 +500,450 @@ int count(struct list *list, void *val, int (*comp)(void *val, struct list *el2)
  * @order: true - ascendeng, false - descending
  *
  * comp has to return 0 if equals, >0 if el1 > el2, <0 if el2 > el1
+ *
+ * Bottom-up merge sort: O(n log n) in worst case, no recursion, no allocation.
+ * Sort is stable in both orders - equal elements keep their relative order.
+ */
+void sort(struct list *list, int (*comp)(struct list *el1, struct list *el2), bool order);
+
+/**
+ * struct list_key - cached sort key of list node. Used as buffer for sort_by_key()
+ * @key: key, converted to unsigned form, which has the same order as sorting
+ * @node: pointer to list node
  */
-void sort(struct list *list, int (*comp)(struct list *el1, struct list *el2), bool order);
\ No newline at end of file
+struct list_key {
+    uint64_t key;
+    struct list *node;
+};
+
+/**
+ * sort_by_key() - sort list by keys, which are extracted once per node
+ * @list: pointer to parent list node. E.g. created with CREATE_LIST
+ * @key(): function, which returns key of list node
+ * @order: true - ascendeng, false - descending
+ * @buf: buffer for keys or NULL to use internal pool
+ * @buf_size: number of struct list_key in buf. Has to be at least 2 * list size
+ *
+ * key() is called exactly once for every node, so payload of node is touched
+ * only once. Then {key, node} pairs are sorted with radix sort in contiguous
+ * buffer and list is relinked in one pass. Sort is stable in both orders.
+ *
+ * Internal pool is allocated on demand, reused between calls and freed with
+ * sort_by_key_free(). It is shared, so it is not thread safe. Use your own 
+ * buffer if you sort from several threads.
+ *
+ * Return:
+ * * OK - sorted
+ * * BUFFER_TOO_SMALL - buf is too small, list is untouched
+ * * NO_MEMORY - internal pool can't grow, list is untouched
+ */
+enum errors sort_by_key(struct list *list, int64_t (*key)(struct list *elem), bool order,
+                        struct list_key *buf, size_t buf_size);
+
+/**
+ * sort_by_key_free() - free internal pool used by sort_by_key()
+ */
+void sort_by_key_free(void);
+
+/*
+ * Typed variants. Functions above take struct list * and call user callbacks
+ * through pointers, which compiler can't inline across list.c. Macros below
+ * work on parent struct directly and generate functions, which callbacks are
+ * inlined into. They need GCC/Clang __typeof__ and attributes.
+ */
+
+/**
+ * list_first_entry(list, type, member) - Get parent struct of the first node
+ * @list: pointer to parent list node. Has to be non-empty
+ * @type: type of parent struct
+ * @member: name of list node in parent struct
+ */
+#define list_first_entry(list, type, member) list_entry((list)->next, type, member)
+
+/**
+ * list_for_each_entry(pos, list, member) - Macro for iterating parent structs
+ * @pos: pointer to current parent struct. Has to be pre-created as type *
+ * @list: pointer to parent list node. E.g. created with CREATE_LIST
+ * @member: name of list node in parent struct
+ */
+#define list_for_each_entry(pos, list, member) \
+        for(pos = list_entry((list)->next, __typeof__(*pos), member); \
+            &pos->member != (list); \
+            pos = list_entry(pos->member.next, __typeof__(*pos), member))
+
+/**
+ * list_for_each_entry_reverse(pos, list, member) - Same as list_for_each_entry() in reverse order
+ */
+#define list_for_each_entry_reverse(pos, list, member) \
+        for(pos = list_entry((list)->prev, __typeof__(*pos), member); \
+            &pos->member != (list); \
+            pos = list_entry(pos->member.prev, __typeof__(*pos), member))
+
+/**
+ * list_for_each_entry_safe(pos, temp, list, member) - Same as list_for_each_entry(), safe against removal
+ * @temp: temporary storage. Has to be pre-created as type *
+ */
+#define list_for_each_entry_safe(pos, temp, list, member) \
+        for(pos = list_entry((list)->next, __typeof__(*pos), member), \
+            temp = list_entry(pos->member.next, __typeof__(*pos), member); \
+            &pos->member != (list); \
+            pos = temp, temp = list_entry(temp->member.next, __typeof__(*pos), member))
+
+/**
+ * SORT_BINS - number of bins used by sort() and DEFINE_LIST_SORT(). Bin i holds
+ * either nothing or sorted chain of 2^i elements, so 64 bins are enough for any list.
+ */
+#define SORT_BINS 64
+
+/**
+ * __list_merge() - merge two sorted NULL-terminated chains linked through next pointer
+ * @a: first chain. Its elements are older, so they win on equality
+ * @b: second chain
+ * @cmp(): comparator of __list_sort()
+ * @ctx: passed to cmp() as is
+ * @order: true - ascendeng, false - descending
+ *
+ * For descending order arguments of cmp() are swapped, so equal elements are
+ * still compared as "not greater" and keep their relative order. Prev pointers
+ * are not touched here, they are restored once after sorting.
+ *
+ * Return: head of merged chain
+ */
+static inline __attribute__((always_inline)) struct list *__list_merge(struct list *a, struct list *b,
+        int (*cmp)(struct list *el1, struct list *el2, const void *ctx), const void *ctx, bool order)
+{
+    struct list head;
+    struct list *tail = &head;
+
+    while(a && b) {
+        if((order ? cmp(a, b, ctx) : cmp(b, a, ctx)) <= 0) {
+            tail->next = a;
+            a = a->next;
+        } else {
+            tail->next = b;
+            b = b->next;
+        }
+        tail = tail->next;
+    }
+    tail->next = a ? a : b;
+    return head.next;
+}
+
+/**
+ * __list_sort() - merge sort engine of sort() and DEFINE_LIST_SORT()
+ * @list: pointer to parent list node
+ * @cmp(): comparator, same as comp() of sort(), with extra ctx argument
+ * @ctx: passed to cmp() as is
+ * @order: true - ascendeng, false - descending
+ *
+ * It is always inlined, so constant cmp() is called directly and can be
+ * inlined too. Not meant to be called by user, use sort() or DEFINE_LIST_SORT().
+ */
+static inline __attribute__((always_inline)) void __list_sort(struct list *list,
+        int (*cmp)(struct list *el1, struct list *el2, const void *ctx), const void *ctx, bool order)
+{
+    struct list *bins[SORT_BINS] = {NULL};
+    struct list *elem, *next, *carry;
+    int i, fill = 0;
+
+    if(list->next == list->prev) return;
+
+    list->prev->next = NULL;
+    for(elem = list->next; elem; elem = next) {
+        next = elem->next;
+        elem->next = NULL;
+        carry = elem;
+        for(i = 0; i < fill && bins[i]; ++i) {
+            carry = __list_merge(bins[i], carry, cmp, ctx, order);
+            bins[i] = NULL;
+        }
+        bins[i] = carry;
+        if(i == fill) ++fill;
+    }
+
+    carry = NULL;
+    for(i = 0; i < fill; ++i) {
+        if(bins[i])
+            carry = carry ? __list_merge(bins[i], carry, cmp, ctx, order) : bins[i];
+    }
+
+    list->next = carry;
+    for(next = list, elem = carry; elem; next = elem, elem = elem->next)
+        elem->prev = next;
+    next->next = list;
+    list->prev = next;
+}
+
+/**
+ * DEFINE_LIST_SORT(name, type, member, cmp) - generate typed sort() as
+ * static void name(struct list *list, bool order)
+ * @name: name of generated function
+ * @type: type of parent struct
+ * @member: name of list node in parent struct
+ * @cmp: int cmp(const type *a, const type *b), <0 if a goes before b. Function
+ *       or macro, it is inlined
+ *
+ * Same stable bottom-up merge sort as sort(), with the same order argument.
+ */
+#define DEFINE_LIST_SORT(name, type, member, cmp) \
+static inline __attribute__((always_inline)) int name##__cmp(struct list *el1, struct list *el2, const void *ctx) \
+{ \
+    (void)ctx; \
+    return cmp(list_entry(el1, const type, member), list_entry(el2, const type, member)); \
+} \
+static __attribute__((unused)) void name(struct list *list, bool order) \
+{ \
+    __list_sort(list, name##__cmp, NULL, order); \
+}
+
+/**
+ * DEFINE_LIST_COUNT(name, type, member, valtype, match) - generate typed count() as
+ * static int name(struct list *list, valtype val)
+ * @name: name of generated function
+ * @type: type of parent struct
+ * @member: name of list node in parent struct
+ * @valtype: type of value, elements are matched with
+ * @match: bool match(valtype val, const type *elem), true if elem is counted.
+ *         Function or macro, it is inlined
+ */
+#define DEFINE_LIST_COUNT(name, type, member, valtype, match) \
+static __attribute__((unused)) int name(struct list *list, valtype val) \
+{ \
+    const type *pos; \
+    int res = 0; \
+    list_for_each_entry(pos, list, member) \
+        res += match(val, pos) ? 1 : 0; \
+    return res; \
+}
+
+/**
+ * DEFINE_LIST_TRAVERSE(name, type, member, func) - generate typed traverse() as
+ * static void name(struct list *list)
+ * @name: name of generated function
+ * @type: type of parent struct
+ * @member: name of list node in parent struct
+ * @func: void func(type *elem). Function or macro, it is inlined. Same as
+ *        traverse(), it can't delete elem
+ */
+#define DEFINE_LIST_TRAVERSE(name, type, member, func) \
+static __attribute__((unused)) void name(struct list *list) \
+{ \
+    type *pos; \
+    list_for_each_entry(pos, list, member) \
+        func(pos); \
+}
+
+/**
+ * struct clist - counted list. List head, which knows number of its elements.
+ * @list: list head itself. Can be used with any macro or function from above,
+ *        as long as they don't add or remove nodes
+ * @size: number of elements in list
+ *
+ * Size is kept up to date only by clist_* functions. Never pass nodes from 
+ * other lists to them, counter will be broken.
+ */
+struct clist {
+    struct list list;
+    int size;
+};
+
+/**
+ * INIT_CLIST(cl) - Initialize existing counted list
+ * @cl: pointer to struct clist
+ */
+#define INIT_CLIST(cl) do { \
+        INIT_LIST(&(cl)->list); (cl)->size = 0; \
+        } while(0)
+
+/**
+ * CREATE_CLIST(name) - Create empty counted list
+ */
+#define CREATE_CLIST(name) struct clist name = {INIT_LIST_HEAD(name.list), 0}
+
+/**
+ * clist_size() - number of elements in counted list. O(1)
+ * @cl: pointer to counted list
+ */
+static inline int clist_size(const struct clist *cl)
+{
+    return cl->size;
+}
+
+/**
+ * clist_insert_before() - add elem before other in counted list
+ * @cl: pointer to counted list, which contains next
+ * @next: pointer to other element. May be &cl->list
+ * @elem: pointer to list node to be added
+ */
+static inline void clist_insert_before(struct clist *cl, struct list *next, struct list *elem)
+{
+    insert_before(next, elem);
+    ++cl->size;
+}
+
+/**
+ * clist_insert_after() - add elem after other in counted list
+ * @cl: pointer to counted list, which contains prev
+ * @prev: pointer to other element. May be &cl->list
+ * @elem: pointer to list node to be added
+ */
+static inline void clist_insert_after(struct clist *cl, struct list *prev, struct list *elem)
+{
+    insert_after(prev, elem);
+    ++cl->size;
+}
+
+/**
+ * clist_add_elem() - add elem to the tail of counted list
+ * @cl: pointer to counted list
+ * @elem: pointer to list node to be added
+ */
+#define clist_add_elem(cl, elem) clist_insert_before((cl), &(cl)->list, (elem))
+
+/**
+ * clist_add_elem_head() - add elem to the head of counted list
+ * @cl: pointer to counted list
+ * @elem: pointer to list node to be added
+ */
+#define clist_add_elem_head(cl, elem) clist_insert_after((cl), &(cl)->list, (elem))
+
+/**
+ * clist_delete_list_entry() - deletes node from counted list and nullifies its pointers
+ * @cl: pointer to counted list, which contains elem
+ * @elem: elem to be deleted
+ */
+static inline void clist_delete_list_entry(struct clist *cl, struct list *elem)
+{
+    delete_list_entry(elem);
+    --cl->size;
+}
+
+/**
+ * clist_reverse() - reverse order of counted list. Size is not changed.
+ * @cl: pointer to counted list
+ */
+#define clist_reverse(cl) reverse(&(cl)->list)
+
+/**
+ * clist_insert_n() - add elem at position n of counted list
+ * @cl: pointer to counted list
+ * @elem: pointer to list node to be added
+ * @n: position of elem after insertion. Negative value counts from the tail:
+ *     -1 adds elem to the tail, -(size + 1) - to the head
+ *
+ * Index is checked in O(1), list is walked from the closest end, so insertion 
+ * takes at most size / 2 steps.
+ *
+ * Return:
+ * * OK - inserted
+ * * INDEX_OUT_OF_BOUNDS - not inserted
+ */
+enum errors clist_insert_n(struct clist *cl, struct list *elem, int n);
+
+/**
+ * clist_get_n() - get element at position n of counted list
+ * @cl: pointer to counted list
+ * @n: position of element. Negative value counts from the tail: -1 is the last
+ *
+ * Same as clist_insert_n(), takes at most size / 2 steps.
+ *
+ * Return: pointer to list node or NULL if n is out of bounds
+ */
+struct list *clist_get_n(struct clist *cl, int n);
+
+/**
+ * clist_delete_n() - delete element at position n of counted list
+ * @cl: pointer to counted list
+ * @n: position of element. Negative value counts from the tail: -1 is the last
+ *
+ * Same as clist_insert_n(), takes at most size / 2 steps.
+ *
+ * Return: pointer to deleted list node or NULL if n is out of bounds
+ */
+struct list *clist_delete_n(struct clist *cl, int n);
+
+/**
+ * clist_clear() - delete nodes of counted list in range [from; to], always safe
+ * @cl: pointer to counted list
+ * @from: start node
+ * @to: end node
+ */
+void clist_clear(struct clist *cl, struct list *from, struct list *to);
+
+/**
+ * clist_clear_all() - delete all nodes in counted list
+ * @cl: pointer to counted list
+ */
+void clist_clear_all(struct clist *cl);
+
+/**
+ * struct hlist_node - node of list with single pointer head. Designed to be part
+ * of data struct, parent struct is got with list_entry()
+ * @next: pointer to next node or NULL
+ * @pprev: pointer to next pointer of previous node (or to first pointer of head),
+ *         so node is removed in O(1) without knowing head
+ *
+ * Used for hash buckets: head is half of struct list.
+ */
+struct hlist_node {
+    struct hlist_node *next, **pprev;
+};
+
+/**
+ * struct hlist_head - head of hlist. NULL-terminated, not circular
+ * @first: pointer to first node or NULL
+ */
+struct hlist_head {
+    struct hlist_node *first;
+};
+
+/**
+ * INIT_HLIST_HEAD(h) - Initialize existing hlist head as empty
+ * @h: pointer to struct hlist_head
+ */
+#define INIT_HLIST_HEAD(h) ((h)->first = NULL)
+
+/**
+ * hlist_for_each(elem, head) - Macro for manual iterating hlist
+ * @elem: pointer to current node. Has to be pre-created as struct hlist_node *
+ * @head: pointer to struct hlist_head
+ */
+#define hlist_for_each(elem, head) for(elem = (head)->first; elem; elem = elem->next)
+
+/**
+ * hlist_for_each_safe(elem, temp, head) - Macro for iterating hlist safe against removal
+ * @elem: pointer to current node. Has to be pre-created as struct hlist_node *
+ * @temp: temporary storage. Has to be pre-created as struct hlist_node *
+ * @head: pointer to struct hlist_head
+ */
+#define hlist_for_each_safe(elem, temp, head) \
+        for(elem = (head)->first; elem && (temp = elem->next, 1); elem = temp)
+
+/**
+ * hlist_add_head() - add node to the head of hlist
+ * @head: pointer to struct hlist_head
+ * @elem: pointer to node to be added
+ */
+static inline void hlist_add_head(struct hlist_head *head, struct hlist_node *elem)
+{
+    elem->next = head->first;
+    if(head->first)
+        head->first->pprev = &elem->next;
+    head->first = elem;
+    elem->pprev = &head->first;
+}
+
+/**
+ * hlist_del() - delete node from its hlist and nullify its pointers
+ * @elem: node to be deleted
+ */
+static inline void hlist_del(struct hlist_node *elem)
+{
+    *elem->pprev = elem->next;
+    if(elem->next)
+        elem->next->pprev = elem->pprev;
+    elem->next = NULL;
+    elem->pprev = NULL;
+}
+
+#endif /* LIST_H */
@@ -0,0 +1,50 @@
+#include "mpsc.h"
+
+void mpsc_init(struct mpsc *q)
+{
+    q->stub.next = q->stub.prev = NULL;
+    q->head = &q->stub;
+    __atomic_store_n(&q->tail, &q->stub, __ATOMIC_RELEASE);
+}
+
+struct list *mpsc_pop(struct mpsc *q)
+{
+    struct list *head = q->head;
+    struct list *next = __atomic_load_n(&head->next, __ATOMIC_ACQUIRE);
+    struct list *tail;
+
+    if(head == &q->stub) {
+        if(!next) return NULL;
+        q->head = head = next;
+        next = __atomic_load_n(&head->next, __ATOMIC_ACQUIRE);
+    }
+    if(next) {
+        q->head = next;
+        return head;
+    }
+
+    tail = __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE);
+    if(head != tail) return NULL;
+
+    //head is the last node, it can't be taken until something is after it.
+    //Put stub there, so queue stays non-empty
+    mpsc_push(q, &q->stub);
+    next = __atomic_load_n(&head->next, __ATOMIC_ACQUIRE);
+    if(next) {
+        q->head = next;
+        return head;
+    }
+    return NULL;
+}
+
+int mpsc_drain(struct mpsc *q, struct list *list)
+{
+    struct list *elem;
+    int res = 0;
+
+    while((elem = mpsc_pop(q))) {
+        add_elem(list, elem);
+        ++res;
+    }
+    return res;
+}
@@ -0,0 +1,75 @@
+#ifndef MPSC_H
+#define MPSC_H
+
+#include "list.h"
+
+/**
+ * MPSC_CACHE_LINE - size of cache line. Producers and consumer sides of queue
+ * are placed in different cache lines to avoid false sharing.
+ */
+#define MPSC_CACHE_LINE 64
+
+/**
+ * struct mpsc - lock-free intrusive multi-producer/single-consumer queue
+ * @tail: last pushed node. Touched by producers only (and consumer, when queue empties)
+ * @head: next node to pop. Touched by consumer only
+ * @stub: node, which is kept in queue, so it never becomes really empty
+ *
+ * Queue is built of usual struct list nodes, embedded in data structure, and 
+ * parent struct is got with list_entry(). While node is in queue, only its next
+ * pointer is used and it is linked as singly linked list.
+ * Based on D. Vyukov's intrusive MPSC queue.
+ */
+struct mpsc {
+    _Alignas(MPSC_CACHE_LINE) struct list *tail;
+    _Alignas(MPSC_CACHE_LINE) struct list *head;
+    struct list stub;
+};
+
+/**
+ * mpsc_init() - initialize empty queue
+ * @q: pointer to queue
+ */
+void mpsc_init(struct mpsc *q);
+
+/**
+ * mpsc_push() - add elem to the tail of queue. Can be called by any thread
+ * @q: pointer to queue
+ * @elem: pointer to list node to be added
+ *
+ * Wait-free: single atomic exchange and one store. Between them elem is not yet
+ * visible to consumer, it will get elem on the next pop.
+ */
+static inline void mpsc_push(struct mpsc *q, struct list *elem)
+{
+    struct list *prev;
+
+    elem->next = NULL;
+    prev = __atomic_exchange_n(&q->tail, elem, __ATOMIC_ACQ_REL);
+    __atomic_store_n(&prev->next, elem, __ATOMIC_RELEASE);
+}
+
+/**
+ * mpsc_pop() - remove node from the head of queue. Only one thread can call it
+ * @q: pointer to queue
+ *
+ * Return: removed list node or NULL if queue is empty (or the only node in
+ * queue is still being pushed)
+ */
+struct list *mpsc_pop(struct mpsc *q);
+
+/**
+ * mpsc_drain() - move all available nodes from queue to the tail of list. Only 
+ * one thread can call it
+ * @q: pointer to queue
+ * @list: pointer to parent list node. E.g. created with CREATE_LIST
+ *
+ * Moved nodes are ordinary list nodes, so list can be walked with
+ * list_for_each_safe() and nodes can be deleted or moved to other lists.
+ * Nodes, pushed by the same thread, keep their order.
+ *
+ * Return: number of moved nodes
+ */
+int mpsc_drain(struct mpsc *q, struct list *list);
+
+#endif /* MPSC_H */
@@ -0,0 +1,285 @@
+#include "nodepool.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * struct node_slab - header at the start of slab, objects follow it
+ * @list: node in list of slabs of pool
+ * @used: allocated objects, cached ones count as allocated
+ */
+struct node_slab {
+    struct list list;
+    size_t used;
+};
+
+/* Objects start at the first cache line after header */
+#define NODE_SLAB_HEADER \
+    ((sizeof(struct node_slab) + NODE_CACHE_LINE - 1) & ~(size_t)(NODE_CACHE_LINE - 1))
+
+static inline struct list *__node_of(struct node_pool *pool, void *obj)
+{
+    return (struct list *)((char *)obj + pool->offset);
+}
+
+static inline void *__obj_of(struct node_pool *pool, struct list *node)
+{
+    return (char *)node - pool->offset;
+}
+
+static inline struct node_slab *__slab_of(void *obj)
+{
+    return (struct node_slab *)((uintptr_t)obj & ~(uintptr_t)(NODE_SLAB_SIZE - 1));
+}
+
+static inline void *__slab_obj(struct node_pool *pool, struct node_slab *slab, size_t i)
+{
+    return (char *)slab + NODE_SLAB_HEADER + i * pool->obj_size;
+}
+
+/**
+ * __new_slab() - allocate slab and add it to pool. Objects are not put on free list
+ */
+static struct node_slab *__new_slab(struct node_pool *pool)
+{
+    struct node_slab *slab = aligned_alloc(NODE_SLAB_SIZE, NODE_SLAB_SIZE);
+    if(!slab)
+        return NULL;
+    slab->used = 0;
+    add_elem(&pool->slabs, &slab->list);
+    return slab;
+}
+
+/**
+ * __grow() - add slab with all objects free. Has to be called under lock
+ *
+ * Return: false if slab can't be allocated
+ */
+static bool __grow(struct node_pool *pool)
+{
+    struct node_slab *slab = __new_slab(pool);
+    if(!slab)
+        return false;
+    //in address order, so consecutive allocations are consecutive in memory
+    for(size_t i = 0; i < pool->per_slab; i++)
+        add_elem(&pool->free, __node_of(pool, __slab_obj(pool, slab, i)));
+    pool->num_free += pool->per_slab;
+    return true;
+}
+
+/**
+ * __take() - move up to num free objects of pool to list. Has to be called under lock
+ *
+ * Return: number of moved objects
+ */
+static int __take(struct node_pool *pool, struct list *list, int num)
+{
+    int res = 0;
+
+    while(res < num) {
+        if(pool->free.next == &pool->free && !__grow(pool))
+            break;
+        struct list *node = pool->free.next;
+        delete_list_entry(node);
+        add_elem(list, node);
+        __slab_of(__obj_of(pool, node))->used++;
+        --pool->num_free;
+        ++res;
+    }
+    return res;
+}
+
+/**
+ * __put() - return object to pool. Has to be called under lock
+ */
+static inline void __put(struct node_pool *pool, void *obj)
+{
+    add_elem_head(&pool->free, __node_of(pool, obj));
+    __slab_of(obj)->used--;
+    ++pool->num_free;
+}
+
+enum errors node_pool_init(struct node_pool *pool, size_t obj_size, size_t offset)
+{
+    size_t align = obj_size > NODE_CACHE_LINE / 2 ? NODE_CACHE_LINE : 16;
+
+    pool->obj_size = (obj_size + align - 1) & ~(align - 1);
+    pool->offset = offset;
+    pool->per_slab = (NODE_SLAB_SIZE - NODE_SLAB_HEADER) / pool->obj_size;
+    if(pool->per_slab == 0)
+        return BUFFER_TOO_SMALL;
+    INIT_LIST(&pool->slabs);
+    INIT_LIST(&pool->free);
+    pool->num_free = 0;
+    pthread_mutex_init(&pool->lock, NULL);
+    return OK;
+}
+
+void node_pool_destroy(struct node_pool *pool)
+{
+    struct list *temp, *safe;
+
+    list_for_each_safe(temp, safe, &pool->slabs)
+        free(list_entry(temp, struct node_slab, list));
+    INIT_LIST(&pool->slabs);
+    INIT_LIST(&pool->free);
+    pool->num_free = 0;
+    pthread_mutex_destroy(&pool->lock);
+}
+
+void *node_pool_alloc(struct node_pool *pool)
+{
+    CREATE_LIST(taken);
+
+    pthread_mutex_lock(&pool->lock);
+    int num = __take(pool, &taken, 1);
+    pthread_mutex_unlock(&pool->lock);
+    if(!num)
+        return NULL;
+    struct list *node = taken.next;
+    delete_list_entry(node);
+    return __obj_of(pool, node);
+}
+
+void node_pool_free(struct node_pool *pool, void *obj)
+{
+    pthread_mutex_lock(&pool->lock);
+    __put(pool, obj);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+int node_pool_trim(struct node_pool *pool)
+{
+    struct list *temp, *safe;
+    int res = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    list_for_each_safe(temp, safe, &pool->slabs) {
+        struct node_slab *slab = list_entry(temp, struct node_slab, list);
+        if(slab->used)
+            continue;
+        //free list is doubly linked, so objects of slab are unlinked in O(1) each
+        for(size_t i = 0; i < pool->per_slab; i++)
+            delete_list_entry(__node_of(pool, __slab_obj(pool, slab, i)));
+        pool->num_free -= pool->per_slab;
+        delete_list_entry(&slab->list);
+        free(slab);
+        ++res;
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return res;
+}
+
+enum errors node_pool_compact(struct node_pool *pool, struct list *list,
+                              void (*relocate)(void *dst, void *src))
+{
+    CREATE_LIST(fresh);
+    struct list *temp, *safe, *prev = list;
+    size_t num = 0, i = 0;
+    struct node_slab *slab = NULL;
+
+    list_for_each(temp, list)
+        ++num;
+    if(!num)
+        return OK;
+
+    //all slabs are allocated first, so failure leaves list untouched
+    pthread_mutex_lock(&pool->lock);
+    for(size_t n = 0; n < num; n += pool->per_slab) {
+        struct node_slab *s = __new_slab(pool);
+        if(!s) {
+            list_for_each_safe(temp, safe, &fresh) {
+                delete_list_entry(temp);
+                free(list_entry(temp, struct node_slab, list));
+            }
+            pthread_mutex_unlock(&pool->lock);
+            return NO_MEMORY;
+        }
+        delete_list_entry(&s->list);
+        add_elem(&fresh, &s->list);
+    }
+
+    list_for_each_safe(temp, safe, list) {
+        void *src = __obj_of(pool, temp);
+        if(i == 0)
+            slab = list_entry(slab ? slab->list.next : fresh.next, struct node_slab, list);
+        void *dst = __slab_obj(pool, slab, i);
+        struct list *node = __node_of(pool, dst);
+
+        memcpy(dst, src, pool->obj_size);
+        __add_elem_middle(prev, node, list);
+        prev = node;
+        slab->used++;
+        if(relocate)
+            relocate(dst, src);
+        __put(pool, src);
+        i = i + 1 == pool->per_slab ? 0 : i + 1;
+    }
+    //put free tail of the last slab on free list
+    for(; i && i < pool->per_slab; i++) {
+        add_elem(&pool->free, __node_of(pool, __slab_obj(pool, slab, i)));
+        ++pool->num_free;
+    }
+    list_splice_tail(&fresh, &pool->slabs);
+    pthread_mutex_unlock(&pool->lock);
+
+    node_pool_trim(pool);
+    return OK;
+}
+
+void node_cache_init(struct node_cache *cache, struct node_pool *pool)
+{
+    cache->pool = pool;
+    INIT_LIST(&cache->free);
+    cache->count = 0;
+}
+
+void *node_cache_alloc(struct node_cache *cache)
+{
+    if(!cache->count) {
+        pthread_mutex_lock(&cache->pool->lock);
+        cache->count = __take(cache->pool, &cache->free, NODE_CACHE_BATCH);
+        pthread_mutex_unlock(&cache->pool->lock);
+        if(!cache->count)
+            return NULL;
+    }
+    struct list *node = cache->free.next;
+    delete_list_entry(node);
+    --cache->count;
+    return __obj_of(cache->pool, node);
+}
+
+void node_cache_free(struct node_cache *cache, void *obj)
+{
+    add_elem_head(&cache->free, __node_of(cache->pool, obj));
+    if(++cache->count < 2 * NODE_CACHE_BATCH)
+        return;
+
+    //the most recently freed are kept, they are likely in cache
+    struct list *temp, *safe;
+    int keep = NODE_CACHE_BATCH;
+    pthread_mutex_lock(&cache->pool->lock);
+    list_for_each_safe(temp, safe, &cache->free) {
+        if(keep) {
+            --keep;
+            continue;
+        }
+        delete_list_entry(temp);
+        __put(cache->pool, __obj_of(cache->pool, temp));
+    }
+    pthread_mutex_unlock(&cache->pool->lock);
+    cache->count = NODE_CACHE_BATCH;
+}
+
+void node_cache_flush(struct node_cache *cache)
+{
+    struct list *temp, *safe;
+
+    pthread_mutex_lock(&cache->pool->lock);
+    list_for_each_safe(temp, safe, &cache->free) {
+        delete_list_entry(temp);
+        __put(cache->pool, __obj_of(cache->pool, temp));
+    }
+    pthread_mutex_unlock(&cache->pool->lock);
+    cache->count = 0;
+}
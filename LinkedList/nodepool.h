@@ -0,0 +1,160 @@
+#ifndef NODEPOOL_H
+#define NODEPOOL_H
+
+#include "list.h"
+
+#include <pthread.h>
+
+/**
+ * NODE_CACHE_LINE - size of cache line. Slabs and objects in them start at
+ * cache line boundary.
+ */
+#define NODE_CACHE_LINE 64
+
+/**
+ * NODE_SLAB_SIZE - size of slab. Slabs are aligned to it, so slab of object is
+ * found by masking its address.
+ */
+#define NODE_SLAB_SIZE 65536
+
+/**
+ * NODE_CACHE_BATCH - number of objects moved between per-thread cache and pool at once
+ */
+#define NODE_CACHE_BATCH 32
+
+/**
+ * struct node_pool - allocator of fixed-size objects with embedded list node
+ * @obj_size: size of object, rounded up to alignment
+ * @offset: offset of struct list member in object
+ * @per_slab: objects in one slab
+ * @slabs: list of slabs
+ * @free: free objects, linked through their own list member
+ * @num_free: number of objects in free
+ * @lock: protects all above, pool can be shared by threads
+ *
+ * list.h never allocates, so nodes usually are malloc()ed one by one and get
+ * scattered over heap. Pool keeps them in slabs and node_pool_compact() moves
+ * nodes of list into consecutive memory in list order.
+ */
+struct node_pool {
+    size_t obj_size;
+    size_t offset;
+    size_t per_slab;
+    struct list slabs;
+    struct list free;
+    size_t num_free;
+    pthread_mutex_t lock;
+};
+
+/**
+ * struct node_cache - per-thread cache of free objects. Lock-free on fast path
+ * @pool: pool, objects are taken from and returned to
+ * @free: cached free objects
+ * @count: number of objects in free
+ *
+ * Every thread has its own cache. Objects can be freed to any cache of the pool.
+ */
+struct node_cache {
+    struct node_pool *pool;
+    struct list free;
+    int count;
+};
+
+/**
+ * node_pool_init() - create empty pool
+ * @pool: pointer to pool
+ * @obj_size: size of object, e.g. sizeof(struct mystruct)
+ * @offset: offset of list member, e.g. offsetof(struct mystruct, list)
+ *
+ * Object alignment is 16 bytes, the same as malloc() gives, or cache line, if
+ * object is bigger than half of it.
+ *
+ * Return:
+ * * OK - created
+ * * BUFFER_TOO_SMALL - object doesn't fit slab
+ */
+enum errors node_pool_init(struct node_pool *pool, size_t obj_size, size_t offset);
+
+/**
+ * node_pool_destroy() - free all slabs. Objects must not be used after it
+ * @pool: pointer to pool
+ */
+void node_pool_destroy(struct node_pool *pool);
+
+/**
+ * node_pool_alloc() - allocate object
+ * @pool: pointer to pool
+ *
+ * Return: pointer to object or NULL if new slab can't be allocated
+ */
+void *node_pool_alloc(struct node_pool *pool);
+
+/**
+ * node_pool_free() - return object to pool
+ * @pool: pointer to pool
+ * @obj: pointer to object, allocated from pool. Must not be on any list
+ */
+void node_pool_free(struct node_pool *pool, void *obj);
+
+/**
+ * node_pool_compact() - move nodes of list into fresh slabs in list order
+ * @pool: pointer to pool, all nodes of list are allocated from it
+ * @list: pointer to parent list node. E.g. created with CREATE_LIST
+ * @relocate: called for every object after it is copied, before old copy is
+ *            freed, to fix other references to it (e.g. other lists the object
+ *            is on). May be NULL
+ *
+ * Objects are copied with memcpy() and list is relinked, so after churn list
+ * walk becomes sequential memory access again. Pointers to objects change.
+ * Slabs, which get empty, are released.
+ * No other thread can use pool during compaction, and per-thread caches
+ * should be flushed before it, or their slabs are kept.
+ *
+ * Return:
+ * * OK - compacted
+ * * NO_MEMORY - new slabs can't be allocated, nothing is moved
+ */
+enum errors node_pool_compact(struct node_pool *pool, struct list *list,
+                              void (*relocate)(void *dst, void *src));
+
+/**
+ * node_pool_trim() - release slabs, which have no allocated objects
+ * @pool: pointer to pool
+ *
+ * Return: number of released slabs
+ */
+int node_pool_trim(struct node_pool *pool);
+
+/**
+ * node_cache_init() - create empty per-thread cache
+ * @cache: pointer to cache
+ * @pool: pointer to pool
+ */
+void node_cache_init(struct node_cache *cache, struct node_pool *pool);
+
+/**
+ * node_cache_alloc() - allocate object from cache. Only owner thread can call it
+ * @cache: pointer to cache
+ *
+ * Takes NODE_CACHE_BATCH objects from pool under its lock, when cache is empty.
+ *
+ * Return: pointer to object or NULL if new slab can't be allocated
+ */
+void *node_cache_alloc(struct node_cache *cache);
+
+/**
+ * node_cache_free() - return object to cache. Only owner thread can call it
+ * @cache: pointer to cache
+ * @obj: pointer to object, allocated from the same pool. Must not be on any list
+ *
+ * When cache holds 2 * NODE_CACHE_BATCH objects, half of them goes back to pool.
+ */
+void node_cache_free(struct node_cache *cache, void *obj);
+
+/**
+ * node_cache_flush() - return all cached objects to pool
+ * @cache: pointer to cache
+ */
+void node_cache_flush(struct node_cache *cache);
+
+#endif /* NODEPOOL_H */
@@ -0,0 +1,112 @@
+#include "rcu.h"
+
+#include <limits.h>
+#include <sched.h>
+
+void rcu_init(struct rcu_domain *d)
+{
+    d->epoch = 1;
+    INIT_LIST(&d->readers);
+    INIT_LIST(&d->callbacks);
+    pthread_mutex_init(&d->lock, NULL);
+}
+
+void rcu_destroy(struct rcu_domain *d)
+{
+    while(d->callbacks.next != &d->callbacks)
+        rcu_reclaim(d);
+    pthread_mutex_destroy(&d->lock);
+}
+
+void rcu_register_reader(struct rcu_domain *d, struct rcu_reader *r)
+{
+    r->epoch = 0;
+    pthread_mutex_lock(&d->lock);
+    add_elem(&d->readers, &r->list);
+    pthread_mutex_unlock(&d->lock);
+}
+
+void rcu_unregister_reader(struct rcu_domain *d, struct rcu_reader *r)
+{
+    pthread_mutex_lock(&d->lock);
+    delete_list_entry(&r->list);
+    pthread_mutex_unlock(&d->lock);
+}
+
+/**
+ * __rcu_advance() - start new epoch
+ *
+ * Return: epoch, which was ended
+ *
+ * Fence orders previous removals before reading reader epochs: either writer
+ * sees reader in critical section, or reader sees list without removed node.
+ */
+static unsigned long __rcu_advance(struct rcu_domain *d)
+{
+    unsigned long res = __atomic_fetch_add(&d->epoch, 1, __ATOMIC_SEQ_CST);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    return res;
+}
+
+/**
+ * __rcu_min_epoch() - the oldest epoch of readers in critical sections
+ *
+ * Has to be called under lock. Returns ULONG_MAX if no reader is in critical section.
+ */
+static unsigned long __rcu_min_epoch(struct rcu_domain *d)
+{
+    unsigned long res = ULONG_MAX, epoch;
+    struct list *temp;
+    list_for_each(temp, &d->readers) {
+        epoch = __atomic_load_n(&list_entry(temp, struct rcu_reader, list)->epoch, __ATOMIC_ACQUIRE);
+        if(epoch && epoch < res)
+            res = epoch;
+    }
+    return res;
+}
+
+void synchronize_rcu(struct rcu_domain *d)
+{
+    unsigned long epoch;
+
+    pthread_mutex_lock(&d->lock);
+    epoch = __rcu_advance(d);
+    while(__rcu_min_epoch(d) <= epoch)
+        sched_yield();
+    pthread_mutex_unlock(&d->lock);
+}
+
+void call_rcu(struct rcu_domain *d, struct rcu_head *head, void (*func)(struct rcu_head *head))
+{
+    head->func = func;
+    pthread_mutex_lock(&d->lock);
+    head->epoch = __rcu_advance(d);
+    add_elem(&d->callbacks, &head->list);
+    pthread_mutex_unlock(&d->lock);
+    rcu_reclaim(d);
+}
+
+int rcu_reclaim(struct rcu_domain *d)
+{
+    CREATE_LIST(ready);
+    struct list *temp, *safe;
+    unsigned long min;
+    int res = 0;
+
+    pthread_mutex_lock(&d->lock);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    min = __rcu_min_epoch(d);
+    list_for_each(temp, &d->callbacks) {
+        if(list_entry(temp, struct rcu_head, list)->epoch >= min)
+            break;
+    }
+    list_cut_range(&ready, d->callbacks.next, temp);
+    pthread_mutex_unlock(&d->lock);
+
+    list_for_each_safe(temp, safe, &ready) {
+        struct rcu_head *head = list_entry(temp, struct rcu_head, list);
+        head->func(head);
+        ++res;
+    }
+    return res;
+}
@@ -0,0 +1,133 @@
+#ifndef RCU_H
+#define RCU_H
+
+#include "list.h"
+
+#include <pthread.h>
+
+/**
+ * RCU_CACHE_LINE - size of cache line. Every reader writes only to its own line.
+ */
+#define RCU_CACHE_LINE 64
+
+/**
+ * struct rcu_domain - epoch based read-copy-update domain
+ * @epoch: global epoch. Incremented by writers, never 0
+ * @readers: registered readers
+ * @callbacks: deferred callbacks, ordered by epoch
+ * @lock: protects readers and callbacks lists. Never taken by readers on read path
+ *
+ * Readers mark their critical sections with epoch they started in. Node, 
+ * removed in epoch E, can be freed when every reader is either outside of
+ * critical section or started it in epoch greater than E.
+ */
+struct rcu_domain {
+    _Alignas(RCU_CACHE_LINE) unsigned long epoch;
+    struct list readers;
+    struct list callbacks;
+    pthread_mutex_t lock;
+};
+
+/**
+ * struct rcu_reader - per-thread reader state
+ * @epoch: epoch of current critical section, 0 if reader is outside of it
+ * @list: node in list of readers of domain
+ */
+struct rcu_reader {
+    _Alignas(RCU_CACHE_LINE) unsigned long epoch;
+    struct list list;
+};
+
+/**
+ * struct rcu_head - deferred reclamation request. Designed to be part of data struct
+ * @list: node in list of callbacks of domain
+ * @func: callback, called after grace period. Use list_entry() to get parent struct
+ * @epoch: epoch, in which request was made
+ */
+struct rcu_head {
+    struct list list;
+    void (*func)(struct rcu_head *head);
+    unsigned long epoch;
+};
+
+/**
+ * rcu_init() - initialize domain
+ * @d: pointer to domain
+ */
+void rcu_init(struct rcu_domain *d);
+
+/**
+ * rcu_destroy() - run all pending callbacks and destroy domain
+ * @d: pointer to domain
+ *
+ * All readers have to be unregistered before.
+ */
+void rcu_destroy(struct rcu_domain *d);
+
+/**
+ * rcu_register_reader() - register reader thread in domain
+ * @d: pointer to domain
+ * @r: pointer to reader state, owned by reader thread
+ */
+void rcu_register_reader(struct rcu_domain *d, struct rcu_reader *r);
+
+/**
+ * rcu_unregister_reader() - unregister reader thread. Has to be outside of critical section
+ * @d: pointer to domain
+ * @r: pointer to reader state
+ */
+void rcu_unregister_reader(struct rcu_domain *d, struct rcu_reader *r);
+
+/**
+ * rcu_read_lock() - enter read-side critical section
+ * @d: pointer to domain
+ * @r: pointer to reader state of current thread
+ *
+ * Never blocks and writes only to reader's own cache line. Full fence makes
+ * epoch visible to writers before any list node is read.
+ * Critical sections can't be nested.
+ */
+static inline void rcu_read_lock(struct rcu_domain *d, struct rcu_reader *r)
+{
+    __atomic_store_n(&r->epoch, __atomic_load_n(&d->epoch, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+/**
+ * rcu_read_unlock() - leave read-side critical section
+ * @r: pointer to reader state of current thread
+ */
+static inline void rcu_read_unlock(struct rcu_reader *r)
+{
+    __atomic_store_n(&r->epoch, 0, __ATOMIC_RELEASE);
+}
+
+/**
+ * synchronize_rcu() - wait till all readers, which could see removed nodes, leave critical sections
+ * @d: pointer to domain
+ *
+ * After return every node removed with delete_list_entry_rcu() before the call
+ * can be reused or freed. Spins (with sched_yield), so it must not be called
+ * from inside of read-side critical section.
+ */
+void synchronize_rcu(struct rcu_domain *d);
+
+/**
+ * call_rcu() - defer func(head) till the end of grace period. Never blocks on readers
+ * @d: pointer to domain
+ * @head: pointer to rcu_head, embedded in removed object
+ * @func: callback, e.g. one which frees object
+ *
+ * Callbacks are run by rcu_reclaim(), which is also called from here.
+ */
+void call_rcu(struct rcu_domain *d, struct rcu_head *head, void (*func)(struct rcu_head *head));
+
+/**
+ * rcu_reclaim() - run callbacks, which grace period has ended
+ * @d: pointer to domain
+ *
+ * Return: number of callbacks run
+ */
+int rcu_reclaim(struct rcu_domain *d);
+
+#endif /* RCU_H */
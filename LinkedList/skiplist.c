@@ -0,0 +1,159 @@
+#include "skiplist.h"
+
+/**
+ * __skip_next() - next node of level
+ *
+ * Return: next node or NULL at the end of level
+ */
+static inline struct skip_node *__skip_next(struct skiplist *sl, struct skip_node *node, int level)
+{
+    if(level)
+        return node->next[level - 1];
+    return node->list.next == skip_end(sl) ? NULL :
+        list_entry(node->list.next, struct skip_node, list);
+}
+
+/**
+ * __skip_height() - random height: level i + 1 gets 1/4 of nodes of level i
+ */
+static int __skip_height(struct skiplist *sl)
+{
+    //xorshift64
+    uint64_t x = sl->seed;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    sl->seed = x;
+
+    int res = 1 + __builtin_ctzll(x | 1ULL << 62) / 2;
+    return res < SKIP_MAX_LEVEL ? res : SKIP_MAX_LEVEL;
+}
+
+/*
+ * Search is done by predicate: it moves forward on every level while node
+ * goes before searched position. Predicates are small and inlined into
+ * specialised copies of __skip_search().
+ */
+struct __skip_key {
+    struct skiplist *sl;
+    struct list *elem;
+    void *val;
+    int (*comp)(void *val, struct list *el2);
+};
+
+/**
+ * __skip_search() - find position on every level
+ * @update: if not NULL, gets the last node before position on every level
+ *
+ * Return: first node after position on level 0 or NULL
+ */
+static inline __attribute__((always_inline)) struct skip_node *
+__skip_search(struct skiplist *sl, struct __skip_key *key,
+              bool (*before)(struct __skip_key *key, struct list *elem),
+              struct skip_node **update)
+{
+    struct skip_node *x = &sl->head, *next;
+
+    for(int level = sl->head.height - 1; level >= 0; level--) {
+        while((next = __skip_next(sl, x, level)) && before(key, &next->list))
+            x = next;
+        if(update)
+            update[level] = x;
+    }
+    return __skip_next(sl, x, 0);
+}
+
+static inline bool __before_or_equal(struct __skip_key *key, struct list *elem)
+{
+    return key->sl->cmp(elem, key->elem) <= 0;
+}
+
+static inline bool __before(struct __skip_key *key, struct list *elem)
+{
+    return key->sl->cmp(elem, key->elem) < 0;
+}
+
+static inline bool __less_than_val(struct __skip_key *key, struct list *elem)
+{
+    return key->comp(key->val, elem) > 0;
+}
+
+static inline bool __not_greater_than_val(struct __skip_key *key, struct list *elem)
+{
+    return key->comp(key->val, elem) >= 0;
+}
+
+void skip_init(struct skiplist *sl, int (*cmp)(struct list *el1, struct list *el2),
+               uint64_t seed)
+{
+    INIT_LIST(&sl->head.list);
+    for(int i = 0; i < SKIP_MAX_LEVEL - 1; i++)
+        sl->head.next[i] = NULL;
+    //head height is the height of the highest node
+    sl->head.height = 1;
+    sl->size = 0;
+    sl->seed = seed ? seed : 0x9E3779B97F4A7C15ULL;
+    sl->cmp = cmp;
+}
+
+void skip_insert(struct skiplist *sl, struct skip_node *node)
+{
+    struct skip_node *update[SKIP_MAX_LEVEL];
+    struct __skip_key key = {.sl = sl, .elem = &node->list};
+    int height = __skip_height(sl);
+
+    __skip_search(sl, &key, __before_or_equal, update);
+    for(int level = sl->head.height; level < height; level++)
+        update[level] = &sl->head;
+    if(height > sl->head.height)
+        sl->head.height = height;
+
+    insert_after(&update[0]->list, &node->list);
+    for(int level = 1; level < height; level++) {
+        node->next[level - 1] = update[level]->next[level - 1];
+        update[level]->next[level - 1] = node;
+    }
+    node->height = height;
+    ++sl->size;
+}
+
+void skip_delete(struct skiplist *sl, struct skip_node *node)
+{
+    struct skip_node *update[SKIP_MAX_LEVEL];
+    struct __skip_key key = {.sl = sl, .elem = &node->list};
+
+    __skip_search(sl, &key, __before, update);
+    for(int level = 1; level < node->height; level++) {
+        struct skip_node *x = update[level];
+        //skip equal nodes before this one
+        while(x->next[level - 1] != node)
+            x = x->next[level - 1];
+        x->next[level - 1] = node->next[level - 1];
+    }
+    delete_list_entry(&node->list);
+    while(sl->head.height > 1 && !sl->head.next[sl->head.height - 2])
+        --sl->head.height;
+    --sl->size;
+}
+
+struct list *skip_lower_bound(struct skiplist *sl, void *val, int (*comp)(void *val, struct list *el2))
+{
+    struct __skip_key key = {.val = val, .comp = comp};
+    struct skip_node *res = __skip_search(sl, &key, __less_than_val, NULL);
+    return res ? &res->list : skip_end(sl);
+}
+
+struct list *skip_upper_bound(struct skiplist *sl, void *val, int (*comp)(void *val, struct list *el2))
+{
+    struct __skip_key key = {.val = val, .comp = comp};
+    struct skip_node *res = __skip_search(sl, &key, __not_greater_than_val, NULL);
+    return res ? &res->list : skip_end(sl);
+}
+
+struct list *skip_find(struct skiplist *sl, void *val, int (*comp)(void *val, struct list *el2))
+{
+    struct list *res = skip_lower_bound(sl, val, comp);
+    if(res == skip_end(sl) || comp(val, res))
+        return NULL;
+    return res;
+}
@@ -0,0 +1,122 @@
+#ifndef SKIPLIST_H
+#define SKIPLIST_H
+
+#include "list.h"
+
+/**
+ * SKIP_MAX_LEVEL - max number of levels of skip list. Every level has 1/4 of
+ * nodes of level below, so 12 levels keep O(log n) up to ~16M nodes. Has to be
+ * the same in all files, which share skip list.
+ */
+#ifndef SKIP_MAX_LEVEL
+#define SKIP_MAX_LEVEL 12
+#endif
+
+/**
+ * struct skip_node - skip list node. Designed to be part of data struct.
+ * @list: level 0 node. Usual list node, parent struct is got with
+ *        list_entry(elem, type, member.list)
+ * @next: next node on levels 1..height-1, NULL at the end of level
+ * @height: number of levels node is on
+ *
+ * Upper levels are singly linked. Every node has room for all of them, whatever
+ * its height: node is embedded in data struct and its height is chosen only in
+ * skip_insert(), so it can't be sized by height. That is 8 * (SKIP_MAX_LEVEL - 1)
+ * bytes per node on 64-bit, lower SKIP_MAX_LEVEL for small lists to save memory.
+ */
+struct skip_node {
+    struct list list;
+    struct skip_node *next[SKIP_MAX_LEVEL - 1];
+    int height;
+};
+
+/**
+ * struct skiplist - ordered intrusive container
+ * @head: head node. head.list is usual list head of all nodes in order, so
+ *        list_for_each() and other read-only macros work with it
+ * @size: number of nodes
+ * @seed: state of random generator of node heights
+ * @cmp: comparator of nodes, the same as for sort()
+ *
+ * Don't change level 0 with list.h functions (insert, delete, sort...): upper
+ * levels would point to wrong nodes. Use skip_insert() and skip_delete().
+ */
+struct skiplist {
+    struct skip_node head;
+    int size;
+    uint64_t seed;
+    int (*cmp)(struct list *el1, struct list *el2);
+};
+
+/**
+ * skip_end(sl) - list head of level 0. It is returned as "not found" and is
+ * the end of range in list_for_each_bounds()
+ * @sl: pointer to skip list
+ */
+#define skip_end(sl) (&(sl)->head.list)
+
+/**
+ * skip_init() - initialize empty skip list
+ * @sl: pointer to skip list
+ * @cmp: comparator of nodes. Returns <0 if el1 goes before el2, 0 if equal
+ * @seed: seed for node heights, any value. Same seed gives the same shape
+ */
+void skip_init(struct skiplist *sl, int (*cmp)(struct list *el1, struct list *el2),
+               uint64_t seed);
+
+/**
+ * skip_size() - number of nodes in O(1)
+ * @sl: pointer to skip list
+ */
+static inline int skip_size(const struct skiplist *sl)
+{
+    return sl->size;
+}
+
+/**
+ * skip_insert() - insert node in order in O(log n)
+ * @sl: pointer to skip list
+ * @node: pointer to skip node to insert
+ *
+ * Node is placed after nodes, equal to it, so insertion is stable.
+ */
+void skip_insert(struct skiplist *sl, struct skip_node *node);
+
+/**
+ * skip_delete() - remove node from skip list in O(log n)
+ * @sl: pointer to skip list
+ * @node: pointer to skip node in sl
+ *
+ * Upper levels are singly linked, so node is found by key. For long runs of
+ * equal nodes this adds the length of run on upper levels, which is 1/4 of it.
+ */
+void skip_delete(struct skiplist *sl, struct skip_node *node);
+
+/**
+ * skip_lower_bound() - first node not less than value in O(log n)
+ * @sl: pointer to skip list
+ * @val: pointer to value
+ * @comp: compares value to node like count(). Returns <0 if val goes
+ *        before el2, 0 if equal. Has to agree with order of sl->cmp
+ *
+ * Return: list node or skip_end(sl), if all nodes are less
+ */
+struct list *skip_lower_bound(struct skiplist *sl, void *val, int (*comp)(void *val, struct list *el2));
+
+/**
+ * skip_upper_bound() - first node greater than value in O(log n)
+ *
+ * The same as skip_lower_bound(). Nodes in [lower_bound; upper_bound) are equal
+ * to value, so range can be walked with list_for_each_bounds().
+ */
+struct list *skip_upper_bound(struct skiplist *sl, void *val, int (*comp)(void *val, struct list *el2));
+
+/**
+ * skip_find() - first node equal to value in O(log n)
+ *
+ * The same as skip_lower_bound().
+ * Return: list node or NULL if there's no such node
+ */
+struct list *skip_find(struct skiplist *sl, void *val, int (*comp)(void *val, struct list *el2));
+
+#endif /* SKIPLIST_H */
@@ -0,0 +1,130 @@
+#include "list.h"
+#include "hashtab.h"
+
+#include <stdio.h>
+
+#ifdef DEBUG
+    #include <assert.h>
+    #define check(expr) assert((expr))
+#else
+    #define check(expr)
+#endif
+
+#define ITEMS 4000
+
+/* Object is on usual list and in hash index at the same time */
+struct item {
+    long key;
+    struct list list;
+    struct hlist_node hash;
+};
+
+static struct item items[ITEMS];
+
+static uint64_t item_hash(const void *key)
+{
+    return *(const long *)key;
+}
+
+static const void *item_key(struct hlist_node *node)
+{
+    return &list_entry(node, struct item, hash)->key;
+}
+
+static bool item_equal(const void *key1, const void *key2)
+{
+    return *(const long *)key1 == *(const long *)key2;
+}
+
+static const struct htab_ops ops = {
+    .hash = item_hash,
+    .key = item_key,
+    .equal = item_equal
+};
+
+static int key_comp(void *val, struct list *el2)
+{
+    return *(long *)val != list_entry(el2, struct item, list)->key;
+}
+
+static long visited = 0;
+static void visit(struct hlist_node *node)
+{
+    (void)node;
+    ++visited;
+}
+
+/* Keys are odd, so even ones are surely missing. Multiplication by odd
+ * number modulo 2^32 is bijection, so they are unique too */
+static long key_of(int i)
+{
+    return 2 * (long)(uint32_t)(i * 2654435761u) + 1;
+}
+
+/**
+ * verify() - find every item, which is in table, and nothing else
+ * @step: items with index divisible by step are in table
+ *
+ * Return: true if htab_find() agrees with count() over list of the same items
+ */
+static inline bool verify(struct htab *ht, struct list *plain, int step)
+{
+    for(int i = 0; i < ITEMS; i++) {
+        long key = key_of(i), missing = key + 1;
+        struct hlist_node *found = htab_find(ht, &key);
+        if((i % step == 0) != (found == &items[i].hash) ||
+           (found != NULL) != (count(plain, &key, key_comp) == 1) ||
+           htab_find(ht, &missing) != NULL)
+            return false;
+    }
+    visited = 0;
+    htab_traverse(ht, visit);
+    return visited == (ITEMS + step - 1) / step && htab_size(ht) == (size_t)visited;
+}
+
+int main()
+{
+    struct htab ht;
+    CREATE_LIST(plain);
+
+    printf("\n____________________________\n");
+    printf("Insert %d items\n", ITEMS);
+
+    if(htab_init(&ht, &ops, 0) != OK) {
+        printf("Failed to allocate memory\n");
+        return 1;
+    }
+    for(int i = 0; i < ITEMS; i++) {
+        items[i].key = key_of(i);
+        add_elem(&plain, &items[i].list);
+        htab_insert(&ht, &items[i].hash);
+    }
+    check(verify(&ht, &plain, 1));
+    printf("Items: %zu, buckets: %zu", htab_size(&ht), (size_t)1 << ht.bits);
+
+    printf("\n____________________________\n");
+    printf("Delete 7/8 of items, table shrinks\n");
+
+    for(int i = 0; i < ITEMS; i++)
+        if(i % 8) {
+            htab_delete(&ht, &items[i].hash);
+            delete_list_entry(&items[i].list);
+        }
+    check(verify(&ht, &plain, 8));
+    printf("Items: %zu, buckets: %zu", htab_size(&ht), (size_t)1 << ht.bits);
+
+    printf("\n____________________________\n");
+    printf("Insert them back, table grows\n");
+
+    for(int i = 0; i < ITEMS; i++)
+        if(i % 8) {
+            htab_insert(&ht, &items[i].hash);
+            add_elem(&plain, &items[i].list);
+        }
+    check(verify(&ht, &plain, 1));
+    printf("Items: %zu, buckets: %zu", htab_size(&ht), (size_t)1 << ht.bits);
+
+    printf("\n____________________________\n");
+    htab_free(&ht);
+    return 0;
+}
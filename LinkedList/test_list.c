@@ -29,11 +29,35 @@ static inline int cmp_test_list_sort(struct list *el1, struct list *el2)
     return cmp_test_list((void *)el1, el2);
 }
 
+static inline int64_t key_test_list(struct list *el)
+{
+    return list_entry(el, struct test, list)->a;
+}
+
 static inline int count_tens(struct list *el)
 {
     return list_entry(el, struct test, list)->a - 10;
 }
 
+static inline int cmp_test(const struct test *el1, const struct test *el2)
+{
+    return el1->a - el2->a;
+}
+
+static inline bool is_ten(int val, const struct test *el)
+{
+    return el->a == val;
+}
+
+static inline void negate(struct test *el)
+{
+    el->a = -el->a;
+}
+
+DEFINE_LIST_SORT(sort_test, struct test, list, cmp_test)
+DEFINE_LIST_COUNT(count_test, struct test, list, int, is_ten)
+DEFINE_LIST_TRAVERSE(negate_test, struct test, list, negate)
+
 int main()
 {
     printf("\n____________________________\n");
@@ -180,6 +204,165 @@ int main()
     sort(&test_list, cmp_test_list_sort, true);
 
     list_for_each(temp, &test_list) {        printf("%d ", list_entry(temp, struct test, list)->a);    }
+    check(test_list.next == &a.list && a.list.next == &a1.list &&
+        a7.list.next == &a8.list && a8.list.next == &test_list &&
+        a8.list.prev == &a7.list && test_list.prev == &a8.list);
+
+    sort(&test_list, cmp_test_list_sort, false);
+    check(test_list.next == &a8.list && a8.list.next == &a7.list &&
+        a1.list.next == &a.list && a.list.next == &test_list &&
+        a.list.prev == &a1.list && test_list.prev == &a.list);
+
+    //Equal elements keep their order in both directions
+    a4.a = a5.a;
+    sort(&test_list, cmp_test_list_sort, true);
+    check(a5.list.next == &a4.list && a4.list.prev == &a5.list);
+    sort(&test_list, cmp_test_list_sort, false);
+    check(a5.list.next == &a4.list && a4.list.prev == &a5.list);
+    a4.a = 40;
+
+    printf("\n____________________________\n");
+    printf("Sort by key\n");
+
+    struct list_key keys[18];
+    error = sort_by_key(&test_list, key_test_list, true, keys, 17);
+    check(error == BUFFER_TOO_SMALL && test_list.next == &a8.list && a.list.next == &test_list);
+
+    error = sort_by_key(&test_list, key_test_list, true, keys, 18);
+    check(error == OK && test_list.next == &a.list && a.list.next == &a1.list &&
+        a7.list.next == &a8.list && a8.list.next == &test_list &&
+        a.list.prev == &test_list && test_list.prev == &a8.list);
+
+    a.a = -10;
+    error = sort_by_key(&test_list, key_test_list, false, NULL, 0);
+    check(error == OK && test_list.next == &a8.list && a8.list.next == &a7.list &&
+        a1.list.next == &a.list && a.list.next == &test_list && test_list.prev == &a.list);
+    a.a = 0;
+    sort_by_key_free();
+
+    list_for_each(temp, &test_list) {
+        printf("%d ", list_entry(temp, struct test, list)->a);
+    }
+
+    printf("\n____________________________\n");
+    printf("Typed sort, count and traverse\n");
+
+    struct test *pos;
+    sort_test(&test_list, false);
+    check(test_list.next == &a8.list && a8.list.next == &a7.list &&
+        a1.list.next == &a.list && a.list.next == &test_list && test_list.prev == &a.list);
+    sort_test(&test_list, true);
+    check(test_list.next == &a.list && a.list.next == &a1.list &&
+        a8.list.next == &test_list && test_list.prev == &a8.list);
+    check(count_test(&test_list, 10) == count_one(&test_list, count_tens));
+
+    negate_test(&test_list);
+    check(a1.a == -10 && a8.a == -80 &&
+        count_test(&test_list, -10) == 1 && count_test(&test_list, 10) == 0);
+    list_for_each_entry_reverse(pos, &test_list, list) {
+        printf("%d ", pos->a);
+    }
+    negate_test(&test_list);
+    check(a1.a == 10 && a8.a == 80 &&
+        count_test(&test_list, 10) == 1 && count_test(&test_list, -10) == 0);
+    check(list_first_entry(&test_list, struct test, list) == &a);
+    sort_test(&test_list, false);
+
+    printf("\n____________________________\n");
+    printf("Splice and cut\n");
+
+    list_cut_range(&test_list1, &a.list, &a.list);
+    check(test_list1.next == &test_list1 && test_list1.prev == &test_list1);
+
+    list_cut_position(&test_list1, &test_list, &a2.list);
+    check(test_list1.next == &a8.list && a8.list.prev == &test_list1 &&
+        test_list1.prev == &a2.list && a2.list.next == &test_list1 &&
+        test_list.next == &a1.list && a1.list.prev == &test_list);
+
+    list_splice(&test_list1, &test_list);
+    check(test_list1.next == &test_list1 && test_list1.prev == &test_list1 &&
+        test_list.next == &a8.list && a8.list.prev == &test_list &&
+        a2.list.next == &a1.list && a1.list.prev == &a2.list);
+
+    list_cut_range(&test_list1, &a6.list, &a3.list);
+    check(test_list1.next == &a6.list && test_list1.prev == &a4.list &&
+        a4.list.next == &test_list1 && a6.list.prev == &test_list1 &&
+        a7.list.next == &a3.list && a3.list.prev == &a7.list);
+    list_for_each(temp, &test_list1) {
+        printf("%d ", list_entry(temp, struct test, list)->a);
+    }
+    printf("\n");
+
+    list_splice_tail(&test_list1, &test_list);
+    check(test_list1.next == &test_list1 && test_list1.prev == &test_list1 &&
+        a.list.next == &a6.list && a6.list.prev == &a.list &&
+        a4.list.next == &test_list && test_list.prev == &a4.list);
+
+    list_cut_position(&test_list1, &test_list, &test_list);
+    check(test_list1.next == &test_list1 && test_list.next == &a8.list);
+    list_splice_tail(&test_list1, &test_list);
+    check(test_list.prev == &a4.list);
+
+    list_for_each(temp, &test_list) {
+        printf("%d ", list_entry(temp, struct test, list)->a);
+    }
+
+    printf("\n____________________________\n");
+    printf("Detach\n");
+
+    clear_detach(&a3.list, &a.list);
+    check(a7.list.next == &a6.list && a6.list.prev == &a7.list &&
+        a3.list.prev == LIST_POISON_PREV && a2.list.next == LIST_POISON_NEXT &&
+        a.list.next == LIST_POISON_NEXT);
+    clear_all_detach(&test_list);
+    check(test_list.next == &test_list && test_list.prev == &test_list &&
+        a8.list.prev == LIST_POISON_PREV && a4.list.next == LIST_POISON_NEXT);
+    clear_all_detach(&test_list);
+    check(test_list.next == &test_list && test_list.prev == &test_list);
+
+    printf("\n____________________________\n");
+    printf("Counted list\n");
+
+    CREATE_CLIST(test_clist);
+    check(clist_size(&test_clist) == 0 && test_clist.list.next == &test_clist.list);
+
+    clist_add_elem(&test_clist, &a1.list);
+    clist_add_elem_head(&test_clist, &a.list);
+    clist_add_elem(&test_clist, &a3.list);
+    check(clist_size(&test_clist) == 3);
+
+    error = clist_insert_n(&test_clist, &a2.list, 2);
+    check(error == OK && a1.list.next == &a2.list && a2.list.next == &a3.list);
+    error = clist_insert_n(&test_clist, &a4.list, -1);
+    check(error == OK && test_clist.list.prev == &a4.list && a3.list.next == &a4.list);
+    error = clist_insert_n(&test_clist, &a5.list, 6);
+    check(error == INDEX_OUT_OF_BOUNDS);
+    error = clist_insert_n(&test_clist, &a5.list, -7);
+    check(error == INDEX_OUT_OF_BOUNDS && clist_size(&test_clist) == 5);
+    error = clist_insert_n(&test_clist, &a5.list, 5);
+    check(error == OK && test_clist.list.prev == &a5.list && clist_size(&test_clist) == 6);
+
+    check(clist_get_n(&test_clist, 0) == &a.list && clist_get_n(&test_clist, 4) == &a4.list &&
+        clist_get_n(&test_clist, -1) == &a5.list && clist_get_n(&test_clist, -6) == &a.list &&
+        clist_get_n(&test_clist, 6) == NULL && clist_get_n(&test_clist, -7) == NULL);
+
+    struct list *deleted = clist_delete_n(&test_clist, -2);
+    check(deleted == &a4.list && a4.list.next == NULL &&
+        a3.list.next == &a5.list && clist_size(&test_clist) == 5);
+    deleted = clist_delete_n(&test_clist, 5);
+    check(deleted == NULL && clist_size(&test_clist) == 5);
+    (void)deleted;
+
+    clist_reverse(&test_clist);
+    check(clist_get_n(&test_clist, 0) == &a5.list && clist_size(&test_clist) == 5);
+
+    clist_clear(&test_clist, &a3.list, &a1.list);
+    check(clist_size(&test_clist) == 2 && a5.list.next == &a.list && a2.list.prev == NULL);
+    clist_delete_list_entry(&test_clist, &a5.list);
+    check(clist_size(&test_clist) == 1 && clist_get_n(&test_clist, 0) == &a.list);
+
+    clist_clear_all(&test_clist);
+    check(clist_size(&test_clist) == 0 && test_clist.list.next == &test_clist.list);
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,163 @@
+#include "list.h"
+#include "mpsc.h"
+#include "test_util.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+
+#ifdef DEBUG
+    #include <assert.h>
+    #define check(expr) assert((expr))
+#else
+    #define check(expr) 
+#endif
+
+struct item {
+    int producer;
+    int seq;
+    struct list list;
+};
+
+struct producer {
+    pthread_t thread;
+    struct item *items;
+    int num_items;
+    struct mpsc *queue;         /* Lock-free mode */
+    struct list *shared;        /* Mutex mode */
+    pthread_mutex_t *lock;
+};
+
+static void *produce_mpsc(void *args)
+{
+    struct producer *p = args;
+    for(int i = 0; i < p->num_items; i++)
+        mpsc_push(p->queue, &p->items[i].list);
+    return NULL;
+}
+
+static void *produce_mutex(void *args)
+{
+    struct producer *p = args;
+    for(int i = 0; i < p->num_items; i++) {
+        pthread_mutex_lock(p->lock);
+        add_elem(p->shared, &p->items[i].list);
+        pthread_mutex_unlock(p->lock);
+    }
+    return NULL;
+}
+
+/**
+ * consume() - walk drained batch, check per-producer order and forget nodes
+ * @batch: drained nodes
+ * @last_seq: last sequence number seen from every producer
+ *
+ * Return: number of nodes in batch
+ */
+static long consume(struct list *batch, int *last_seq)
+{
+    struct list *temp, *safe;
+    long res = 0;
+    list_for_each_safe(temp, safe, batch) {
+        struct item *it = list_entry(temp, struct item, list);
+        if(it->seq != last_seq[it->producer] + 1) {
+            fprintf(stderr, "Producer %d: got %d after %d\n",
+                it->producer, it->seq, last_seq[it->producer]);
+            exit(EXIT_FAILURE);
+        }
+        last_seq[it->producer] = it->seq;
+        ++res;
+    }
+    clear_all_detach(batch);
+    return res;
+}
+
+/**
+ * run() - push all items from producers and drain them in main thread
+ * @lockfree: true - use mpsc queue, false - use list protected with mutex
+ *
+ * Return: time in milliseconds
+ */
+static double run(struct producer *prod, int num_prod, int num_items, bool lockfree)
+{
+    struct mpsc queue;
+    CREATE_LIST(shared);
+    CREATE_LIST(batch);
+    pthread_mutex_t lock;
+    int last_seq[num_prod];
+    long total = 0, expected = (long)num_prod * num_items;
+    struct timespec start, stop;
+
+    mpsc_init(&queue);
+    pthread_mutex_init(&lock, NULL);
+    for(int i = 0; i < num_prod; i++) {
+        last_seq[i] = -1;
+        prod[i].queue = &queue;
+        prod[i].shared = &shared;
+        prod[i].lock = &lock;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(int i = 0; i < num_prod; i++)
+        pthread_create(&prod[i].thread, NULL, lockfree ? produce_mpsc : produce_mutex, &prod[i]);
+
+    while(total < expected) {
+        if(lockfree) {
+            mpsc_drain(&queue, &batch);
+        } else {
+            pthread_mutex_lock(&lock);
+            list_splice_tail(&shared, &batch);
+            pthread_mutex_unlock(&lock);
+        }
+        total += consume(&batch, last_seq);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &stop);
+
+    for(int i = 0; i < num_prod; i++) {
+        pthread_join(prod[i].thread, NULL);
+        check(last_seq[i] == num_items - 1);
+    }
+    struct list *rest = mpsc_pop(&queue);
+    check(total == expected && rest == NULL && shared.next == &shared);
+    (void)rest;
+    pthread_mutex_destroy(&lock);
+    return time_diff(&stop, &start);
+}
+
+int main(int argc, char *argv[])
+{
+    int num_prod = argc > 1 ? atoi(argv[1]) : 4;
+    int num_items = argc > 2 ? atoi(argv[2]) : 1000000;
+
+    if(num_prod <= 0 || num_items <= 0) {
+        fprintf(stderr, "Usage: %s [PRODUCERS] [ITEMS_PER_PRODUCER]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    struct producer prod[num_prod];
+    for(int i = 0; i < num_prod; i++) {
+        prod[i].items = malloc(num_items * sizeof(*prod[i].items));
+        if(!prod[i].items) {
+            fprintf(stderr, "Failed to allocate memory\n");
+            return EXIT_FAILURE;
+        }
+        prod[i].num_items = num_items;
+        for(int j = 0; j < num_items; j++) {
+            prod[i].items[j].producer = i;
+            prod[i].items[j].seq = j;
+        }
+    }
+
+    printf("Producers: %d, items per producer: %d\n", num_prod, num_items);
+    double items = (double)num_prod * num_items;
+    double t_mutex = run(prod, num_prod, num_items, false);
+    printf("mutex + add_elem: %10.2f ms, %8.2f Mitems/s\n", t_mutex, items / t_mutex / 1e3);
+    double t_mpsc = run(prod, num_prod, num_items, true);
+    printf("lock-free mpsc:   %10.2f ms, %8.2f Mitems/s\n", t_mpsc, items / t_mpsc / 1e3);
+    printf("Speedup: %.2f\n", t_mutex / t_mpsc);
+
+    for(int i = 0; i < num_prod; i++)
+        free(prod[i].items);
+    return 0;
+}
@@ -0,0 +1,169 @@
+#include "list.h"
+#include "nodepool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#ifdef DEBUG
+    #include <assert.h>
+    #define check(expr) assert((expr))
+#else
+    #define check(expr)
+#endif
+
+#define ITEMS 100000
+#define THREADS 4
+
+struct item {
+    int seq;
+    long payload[5];
+    struct list list;
+};
+
+struct worker {
+    pthread_t thread;
+    struct node_pool *pool;
+    int rounds;
+    long errors;
+};
+
+static struct item *all[2 * ITEMS];
+
+static long sum(struct list *list)
+{
+    struct list *temp;
+    long res = 0;
+    list_for_each(temp, list)
+        res += list_entry(temp, struct item, list)->payload[0];
+    return res;
+}
+
+/**
+ * compacted() - check list after node_pool_compact()
+ *
+ * Return: true if order and contents are kept and objects are consecutive
+ * in memory within every slab
+ */
+static inline bool compacted(struct node_pool *pool, struct list *list)
+{
+    struct list *temp;
+    struct item *prev = NULL;
+    int i = 0;
+
+    list_for_each(temp, list) {
+        struct item *it = list_entry(temp, struct item, list);
+        if(it->seq != i || it->payload[0] != i)
+            return false;
+        if(prev && (size_t)((char *)it - (char *)prev) != pool->obj_size && i % pool->per_slab)
+            return false;
+        prev = it;
+        ++i;
+    }
+    return i == ITEMS;
+}
+
+/* Every thread allocates and frees through its own cache */
+static void *worker_func(void *args)
+{
+    struct worker *w = args;
+    struct node_cache cache;
+    CREATE_LIST(local);
+    struct list *temp, *safe;
+
+    node_cache_init(&cache, w->pool);
+    for(int r = 0; r < w->rounds; r++) {
+        for(int i = 0; i < 100; i++) {
+            struct item *it = node_cache_alloc(&cache);
+            if(!it) {
+                ++w->errors;
+                break;
+            }
+            it->seq = i;
+            add_elem(&local, &it->list);
+        }
+        int i = 0;
+        list_for_each_safe(temp, safe, &local) {
+            struct item *it = list_entry(temp, struct item, list);
+            w->errors += it->seq != i++;
+            delete_list_entry(temp);
+            node_cache_free(&cache, it);
+        }
+    }
+    node_cache_flush(&cache);
+    return NULL;
+}
+
+int main()
+{
+    struct node_pool pool;
+    struct worker workers[THREADS];
+    CREATE_LIST(items);
+    struct list *temp;
+
+    printf("\n____________________________\n");
+    printf("Churn: allocate %d objects, free random half\n", 2 * ITEMS);
+
+    if(node_pool_init(&pool, sizeof(struct item), offsetof(struct item, list)) != OK) {
+        printf("Failed to create pool\n");
+        return 1;
+    }
+    srand(42);
+    for(int i = 0; i < 2 * ITEMS; i++) {
+        all[i] = node_pool_alloc(&pool);
+        check(all[i] != NULL);
+    }
+    for(int i = 2 * ITEMS - 1; i > 0; i--) {
+        int j = rand() % (i + 1);
+        struct item *t = all[i];
+        all[i] = all[j];
+        all[j] = t;
+    }
+    for(int i = ITEMS; i < 2 * ITEMS; i++)
+        node_pool_free(&pool, all[i]);
+    //the rest is linked in random order of memory
+    for(int i = 0; i < ITEMS; i++) {
+        all[i]->seq = i;
+        all[i]->payload[0] = i;
+        add_elem(&items, &all[i]->list);
+    }
+    long sum_before = sum(&items);
+    printf("Items: %d, objects in slab: %zu", ITEMS, pool.per_slab);
+
+    printf("\n____________________________\n");
+    printf("Compact list into consecutive memory\n");
+
+    enum errors error = node_pool_compact(&pool, &items, NULL);
+    check(error == OK && compacted(&pool, &items) && sum(&items) == sum_before);
+    (void)error;
+    (void)sum_before;
+    printf("Same order and contents, consecutive in slabs");
+
+    printf("\n____________________________\n");
+    printf("%d threads allocate and free through own caches\n", THREADS);
+
+    for(int t = 0; t < THREADS; t++) {
+        workers[t].pool = &pool;
+        workers[t].rounds = 1000;
+        workers[t].errors = 0;
+        pthread_create(&workers[t].thread, NULL, worker_func, &workers[t]);
+    }
+    for(int t = 0; t < THREADS; t++) {
+        pthread_join(workers[t].thread, NULL);
+        check(workers[t].errors == 0);
+    }
+
+    //everything but list items is back in pool, slabs of workers are empty
+    int trimmed = node_pool_trim(&pool);
+    size_t slabs = 0;
+    list_for_each(temp, &pool.slabs)
+        ++slabs;
+    check(pool.num_free + ITEMS == slabs * pool.per_slab);
+    check(slabs == (ITEMS + pool.per_slab - 1) / pool.per_slab);
+    printf("Released slabs: %d, left: %zu", trimmed, slabs);
+
+    printf("\n____________________________\n");
+    node_pool_destroy(&pool);
+    return 0;
+}
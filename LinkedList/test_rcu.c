@@ -0,0 +1,133 @@
+#include "list.h"
+#include "rcu.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#ifdef DEBUG
+    #include <assert.h>
+    #define check(expr) assert((expr))
+#else
+    #define check(expr) 
+#endif
+
+#define ALIVE 0x600DF00D
+#define DEAD 0xDEADBEEF
+
+struct item {
+    unsigned int magic;
+    struct list list;
+    struct rcu_head rcu;
+};
+
+struct reader {
+    pthread_t thread;
+    struct rcu_reader rcu;
+    long walks, seen, errors;
+};
+
+static struct rcu_domain domain;
+static CREATE_LIST(items);
+static bool stop = false;
+
+/* Instead of free() item is marked, so reader, which sees it, is caught */
+static void reclaim_item(struct rcu_head *head)
+{
+    list_entry(head, struct item, rcu)->magic = DEAD;
+}
+
+static void *reader_func(void *args)
+{
+    struct reader *r = args;
+    struct list *temp;
+
+    rcu_register_reader(&domain, &r->rcu);
+    while(!__atomic_load_n(&stop, __ATOMIC_RELAXED)) {
+        rcu_read_lock(&domain, &r->rcu);
+        list_for_each_rcu(temp, &items) {
+            if(list_entry(temp, struct item, list)->magic != ALIVE)
+                ++r->errors;
+            ++r->seen;
+        }
+        rcu_read_unlock(&r->rcu);
+        ++r->walks;
+    }
+    rcu_unregister_reader(&domain, &r->rcu);
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    int num_readers = argc > 1 ? atoi(argv[1]) : 4;
+    int num_updates = argc > 2 ? atoi(argv[2]) : 200000;
+    int list_size = 64, next = 0;
+
+    if(num_readers <= 0 || num_updates <= 0) {
+        fprintf(stderr, "Usage: %s [READERS] [UPDATES]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    struct item *pool = malloc((list_size + num_updates) * sizeof(*pool));
+    struct reader readers[num_readers];
+    if(!pool) {
+        fprintf(stderr, "Failed to allocate memory\n");
+        return EXIT_FAILURE;
+    }
+
+    rcu_init(&domain);
+    for(; next < list_size; next++) {
+        pool[next].magic = ALIVE;
+        add_elem(&items, &pool[next].list);
+    }
+    for(int i = 0; i < num_readers; i++) {
+        readers[i].walks = readers[i].seen = readers[i].errors = 0;
+        pthread_create(&readers[i].thread, NULL, reader_func, &readers[i]);
+    }
+
+    //Writer: replace random node with new one, old one is reclaimed after grace period
+    srand(0);
+    for(int i = 0; i < num_updates; i++) {
+        struct list *temp = items.next;
+        for(int n = rand() % list_size; n > 0; n--)
+            temp = temp->next;
+        delete_list_entry_rcu(temp);
+        if(i % 1024)
+            call_rcu(&domain, &list_entry(temp, struct item, list)->rcu, reclaim_item);
+        else {
+            synchronize_rcu(&domain);
+            reclaim_item(&list_entry(temp, struct item, list)->rcu);
+        }
+
+        pool[next].magic = ALIVE;
+        if(i % 2)
+            add_elem_rcu(&items, &pool[next].list);
+        else
+            add_elem_head_rcu(&items, &pool[next].list);
+        next++;
+    }
+
+    __atomic_store_n(&stop, true, __ATOMIC_RELAXED);
+    long walks = 0, seen = 0, errors = 0;
+    for(int i = 0; i < num_readers; i++) {
+        pthread_join(readers[i].thread, NULL);
+        walks += readers[i].walks;
+        seen += readers[i].seen;
+        errors += readers[i].errors;
+    }
+    rcu_destroy(&domain);
+
+    int dead = 0;
+    for(int i = 0; i < next; i++)
+        dead += pool[i].magic == DEAD;
+    check(dead == num_updates);
+
+    printf("Readers: %d, updates: %d\n", num_readers, num_updates);
+    printf("Walks: %ld, nodes seen: %ld, reclaimed nodes seen: %ld\n", walks, seen, errors);
+    free(pool);
+    if(errors) {
+        fprintf(stderr, "Reader saw reclaimed node\n");
+        return EXIT_FAILURE;
+    }
+    return 0;
+}
@@ -0,0 +1,139 @@
+#include "list.h"
+#include "skiplist.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef DEBUG
+    #include <assert.h>
+    #define check(expr) assert((expr))
+#else
+    #define check(expr)
+#endif
+
+#define ITEMS 10000
+//small range to get many equal keys
+#define RANGE (ITEMS / 4 + 1)
+
+struct item {
+    int key;
+    int seq;
+    struct skip_node skip;
+};
+
+static struct item items[ITEMS];
+static int keys[ITEMS];
+
+static int item_cmp(struct list *el1, struct list *el2)
+{
+    int k1 = list_entry(el1, struct item, skip.list)->key;
+    int k2 = list_entry(el2, struct item, skip.list)->key;
+    return (k1 > k2) - (k1 < k2);
+}
+
+static int key_cmp(void *val, struct list *el2)
+{
+    int k1 = *(int *)val;
+    int k2 = list_entry(el2, struct item, skip.list)->key;
+    return (k1 > k2) - (k1 < k2);
+}
+
+static int int_cmp(const void *a, const void *b)
+{
+    return (*(int *)a > *(int *)b) - (*(int *)a < *(int *)b);
+}
+
+/**
+ * verify() - compare skip list with sorted array of its keys
+ * @keys: sorted keys
+ * @num: number of keys
+ *
+ * Return: true if order, stability, bounds and find agree with array
+ */
+static inline bool verify(struct skiplist *sl, const int *keys, int num)
+{
+    struct list *temp;
+    int i = 0, prev_key = -1, prev_seq = -1;
+
+    if(skip_size(sl) != num)
+        return false;
+    list_for_each(temp, skip_end(sl)) {
+        struct item *it = list_entry(temp, struct item, skip.list);
+        //equal keys keep order of insertion
+        if(it->key != keys[i] || (it->key == prev_key && it->seq < prev_seq))
+            return false;
+        prev_key = it->key;
+        prev_seq = it->seq;
+        ++i;
+    }
+    int lo = 0, hi;
+    for(int key = -1; key <= RANGE; key++) {
+        int n = 0;
+        while(lo < num && keys[lo] < key) lo++;
+        hi = lo;
+        while(hi < num && keys[hi] == key) hi++;
+
+        struct list *lower = skip_lower_bound(sl, &key, key_cmp);
+        struct list *upper = skip_upper_bound(sl, &key, key_cmp);
+        if((lo == num) != (lower == skip_end(sl)) ||
+           (lo < num && list_entry(lower, struct item, skip.list)->key != keys[lo]) ||
+           (hi == num) != (upper == skip_end(sl)))
+            return false;
+        list_for_each_bounds(temp, lower, upper)
+            ++n;
+        if(n != hi - lo || (hi > lo) != (skip_find(sl, &key, key_cmp) != NULL))
+            return false;
+    }
+    return true;
+}
+
+int main()
+{
+    struct skiplist sl;
+    int left = 0;
+
+    printf("\n____________________________\n");
+    printf("Insert %d items with keys in [0; %d)\n", ITEMS, RANGE);
+
+    srand(42);
+    skip_init(&sl, item_cmp, 42);
+    for(int i = 0; i < ITEMS; i++) {
+        items[i].key = rand() % RANGE;
+        items[i].seq = i;
+        skip_insert(&sl, &items[i].skip);
+    }
+    for(int i = 0; i < ITEMS; i++)
+        keys[i] = items[i].key;
+    qsort(keys, ITEMS, sizeof(*keys), int_cmp);
+    check(verify(&sl, keys, ITEMS));
+    printf("Levels: %d", sl.head.height);
+
+    printf("\n____________________________\n");
+    printf("Delete every odd item\n");
+
+    for(int i = 1; i < ITEMS; i += 2)
+        skip_delete(&sl, &items[i].skip);
+    for(int i = 0; i < ITEMS; i += 2)
+        keys[left++] = items[i].key;
+    qsort(keys, left, sizeof(*keys), int_cmp);
+    check(verify(&sl, keys, left));
+    printf("Items left: %d, levels: %d", skip_size(&sl), sl.head.height);
+
+    printf("\n____________________________\n");
+    printf("Insert them back\n");
+
+    //they go after equal ones, which are in list now
+    for(int i = 1; i < ITEMS; i += 2) {
+        items[i].seq = ITEMS + i;
+        skip_insert(&sl, &items[i].skip);
+    }
+    for(int i = 0; i < ITEMS; i++)
+        keys[i] = items[i].key;
+    qsort(keys, ITEMS, sizeof(*keys), int_cmp);
+    check(verify(&sl, keys, ITEMS));
+    check(skip_find(&sl, &(int){RANGE}, key_cmp) == NULL);
+    printf("Items: %d, levels: %d", skip_size(&sl), sl.head.height);
+
+    printf("\n____________________________\n");
+    return 0;
+}
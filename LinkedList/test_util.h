@@ -0,0 +1,16 @@
+#ifndef TEST_UTIL_H
+#define TEST_UTIL_H
+
+#include <time.h>
+
+/**
+ * time_diff - milliseconds between two clock_gettime() readings
+ * @stop: later reading
+ * @start: earlier reading
+ */
+static inline double time_diff(const struct timespec *stop, const struct timespec *start)
+{
+    return (stop->tv_sec - start->tv_sec) * 1e3 + (stop->tv_nsec - start->tv_nsec) / 1e6;
+}
+
+#endif /* TEST_UTIL_H */
@@ -0,0 +1,171 @@
+#include "bench.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+static const char * const _format_names[] = {
+	[BF_CSV] = "csv",
+	[BF_JSON] = "json"
+};
+
+double bench_now(void)
+{
+	struct timespec ts;
+	clock_gettime(BENCH_CLOCK, &ts);
+	return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+	double x = *(const double *)a, y = *(const double *)b;
+	return (x > y) - (x < y);
+}
+
+static int cmp_ll(const void *a, const void *b)
+{
+	long long x = *(const long long *)a, y = *(const long long *)b;
+	return (x > y) - (x < y);
+}
+
+void bench_stats(double *samples, int num, struct bench_stats *st)
+{
+	double sum = 0., sq = 0.;
+
+	qsort(samples, num, sizeof *samples, cmp_double);
+	for (int i = 0; i < num; i++)
+		sum += samples[i];
+	st->num = num;
+	st->mean = sum / num;
+	for (int i = 0; i < num; i++)
+		sq += (samples[i] - st->mean) * (samples[i] - st->mean);
+	st->stddev = num > 1 ? sqrt(sq / (num - 1)) : 0.;
+	st->min = samples[0];
+	st->median = num % 2 ? samples[num / 2]
+			     : (samples[num / 2 - 1] + samples[num / 2]) / 2;
+	/* nearest rank: ceil(0.95 * num) - 1 */
+	st->p95 = samples[(95 * num + 99) / 100 - 1];
+}
+
+int bench_parse_list(const char *str, long long *vals, int max)
+{
+	int num = 0;
+	char *end;
+
+	while (*str) {
+		if (num == max)
+			return -1;
+		vals[num] = strtoll(str, &end, 10);
+		if (end == str || vals[num] <= 0 || (*end && *end != ','))
+			return -1;
+		num++;
+		str = *end ? end + 1 : end;
+	}
+	qsort(vals, num, sizeof *vals, cmp_ll);
+	return num ? num : -1;
+}
+
+enum bench_format bench_parse_format(const char *name)
+{
+	enum bench_format f;
+	for (f = 0; f < BF_COUNT; f++)
+		if (!strcmp(name, _format_names[f]))
+			break;
+	return f;
+}
+
+/* Field of CSV: quoted, if it has separator, quote or line break (RFC 4180) */
+static void put_csv(FILE *fp, const char *str)
+{
+	if (!str[strcspn(str, ",\"\r\n")]) {
+		fputs(str, fp);
+		return;
+	}
+	fputc('"', fp);
+	for (; *str; str++) {
+		if ('"' == *str)
+			fputc('"', fp);
+		fputc(*str, fp);
+	}
+	fputc('"', fp);
+}
+
+/* String of JSON with quotes, backslashes and control characters escaped */
+static void put_json(FILE *fp, const char *str)
+{
+	fputc('"', fp);
+	for (; *str; str++) {
+		unsigned char c = *str;
+		if ('"' == c || '\\' == c)
+			fprintf(fp, "\\%c", c);
+		else if (c < 0x20)
+			fprintf(fp, "\\u%04x", c);
+		else
+			fputc(c, fp);
+	}
+	fputc('"', fp);
+}
+
+void bench_begin(FILE *fp, enum bench_format fmt, const char * const *labels)
+{
+	if (BF_JSON == fmt) {
+		fprintf(fp, "[\n");
+		return;
+	}
+	for (; NULL != labels && NULL != *labels; labels += 2) {
+		put_csv(fp, *labels);
+		fputc(',', fp);
+	}
+	fprintf(fp, "threads,size,reps,min_ms,median_ms,p95_ms,mean_ms,"
+		    "stddev_ms,elems_per_s,gb_per_s,speedup,efficiency,value\n");
+}
+
+void bench_print(FILE *fp, enum bench_format fmt, const struct bench_row *row,
+		 int first)
+{
+	const struct bench_stats *st = &row->stats;
+	const char * const *l = row->labels;
+	/* Throughput by median, it is not affected by outliers */
+	double eps = row->size / (st->median / 1e3);
+	double gbps = eps * row->elem_size / 1e9;
+	double eff = row->speedup * row->base / row->threads;
+
+	if (BF_JSON == fmt) {
+		fprintf(fp, "%s  {", first ? "" : ",\n");
+		for (; NULL != l && NULL != *l; l += 2) {
+			put_json(fp, l[0]);
+			fputs(": ", fp);
+			put_json(fp, l[1]);
+			fputs(", ", fp);
+		}
+		fprintf(fp, "\"threads\": %d, \"size\": %lld, \"reps\": %d, "
+			    "\"min_ms\": %.6g, \"median_ms\": %.6g, "
+			    "\"p95_ms\": %.6g, \"mean_ms\": %.6g, "
+			    "\"stddev_ms\": %.6g, \"elems_per_s\": %.6g, "
+			    "\"gb_per_s\": %.6g, \"speedup\": %.4g, "
+			    "\"efficiency\": %.4g, \"value\": ",
+			row->threads, row->size, st->num, st->min, st->median,
+			st->p95, st->mean, st->stddev, eps, gbps, row->speedup,
+			eff);
+		/* JSON has no inf and nan */
+		if (isfinite(row->value))
+			fprintf(fp, "%.17g}", row->value);
+		else
+			fprintf(fp, "null}");
+		return;
+	}
+	for (; NULL != l && NULL != *l; l += 2) {
+		put_csv(fp, l[1]);
+		fputc(',', fp);
+	}
+	fprintf(fp, "%d,%lld,%d,%.6g,%.6g,%.6g,%.6g,%.6g,%.6g,%.6g,%.4g,%.4g,%.17g\n",
+		row->threads, row->size, st->num, st->min, st->median, st->p95,
+		st->mean, st->stddev, eps, gbps, row->speedup, eff, row->value);
+}
+
+void bench_end(FILE *fp, enum bench_format fmt)
+{
+	if (BF_JSON == fmt)
+		fprintf(fp, "\n]\n");
+	fflush(fp);
+}
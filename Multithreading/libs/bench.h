@@ -0,0 +1,108 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdio.h>
+#include <time.h>
+
+/* Neither stepped nor slewed by NTP, so intervals are not distorted */
+#define BENCH_CLOCK CLOCK_MONOTONIC_RAW
+
+/* Max number of values in list of threads or sizes */
+#define BENCH_MAX_LIST 64
+
+enum bench_format {
+	BF_CSV = 0,
+	BF_JSON,
+	BF_COUNT
+};
+
+/**
+ * struct bench_stats - statistics of repeated measurement, in ms.
+ * @num:	number of samples.
+ * @min:	minimum.
+ * @median:	median.
+ * @p95:	95th percentile (nearest rank).
+ * @mean:	arithmetic mean.
+ * @stddev:	sample standard deviation, 0 for one sample.
+ */
+struct bench_stats {
+	int num;
+	double min, median, p95, mean, stddev;
+};
+
+/**
+ * struct bench_row - one configuration of benchmark sweep.
+ * @threads:	number of threads.
+ * @size:	number of elements.
+ * @elem_size:	bytes per element, for bandwidth.
+ * @stats:	time of one run.
+ * @speedup:	median of base thread count / median of this one.
+ * @base:	thread count, speedup is relative to.
+ * @value:	result of the last run.
+ * @labels:	names of other parameters, e.g. {"kernel", "avx2", NULL}.
+ */
+struct bench_row {
+	int threads;
+	long long size;
+	size_t elem_size;
+	struct bench_stats stats;
+	double speedup;
+	int base;
+	double value;
+	const char * const *labels;
+};
+
+/**
+ * bench_now() - current time of BENCH_CLOCK in ms.
+ */
+double bench_now(void);
+
+/**
+ * bench_stats() - compute statistics of samples.
+ * @samples:	times in ms. Are sorted in place.
+ * @num:	number of samples, > 0.
+ * @st:		where to store result.
+ */
+void bench_stats(double *samples, int num, struct bench_stats *st);
+
+/**
+ * bench_parse_list() - parse comma-separated list of positive integers.
+ * @str:	string like "1,2,8".
+ * @vals:	where to store values, sorted ascending.
+ * @max:	size of vals.
+ *
+ * Return: number of values or -1 if string is malformed or too long.
+ */
+int bench_parse_list(const char *str, long long *vals, int max);
+
+/**
+ * bench_parse_format() - find format by name.
+ *
+ * Return: format or BF_COUNT if name is unknown.
+ */
+enum bench_format bench_parse_format(const char *name);
+
+/**
+ * bench_begin() - print header of result table.
+ * @fp:		output stream.
+ * @fmt:	output format.
+ * @labels:	label names and values as in struct bench_row.
+ */
+void bench_begin(FILE *fp, enum bench_format fmt, const char * const *labels);
+
+/**
+ * bench_print() - print one row of result table.
+ * @fp:		output stream.
+ * @fmt:	output format.
+ * @row:	row to print.
+ * @first:	row is the first one (JSON needs no comma before it).
+ */
+void bench_print(FILE *fp, enum bench_format fmt, const struct bench_row *row,
+		 int first);
+
+/**
+ * bench_end() - print footer of result table.
+ */
+void bench_end(FILE *fp, enum bench_format fmt);
+
+#endif /* BENCH_H */
@@ -0,0 +1,160 @@
+#include "logsum.h"
+
+#include <stdbool.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+
+/* Bit patterns and constants, shared by all kernels */
+#define MANT_MASK	0x000FFFFFFFFFFFFFLLU	/* mantissa bits */
+#define EXP_ONE		0x3FF0000000000000LLU	/* 1.0 */
+#define EXP_HALF	0x3FE0000000000000LLU	/* 0.5 */
+/* (double)(MAGIC_BITS | n) - MAGIC == n for n < 2^52, as there is no
+ * int64 -> double vector conversion before AVX-512DQ.
+ * Bits are unsigned, as there is no 64-bit arithmetic shift before AVX-512 */
+#define MAGIC_BITS	0x4330000000000000LLU
+#define MAGIC		4503599627370496.	/* 2^52 */
+#define SQRT2		1.41421356237309504880
+#define LN2		6.93147180559945309417e-01
+#define LN2_HI		6.93147180369123816490e-01
+#define LN2_LO		1.90821492927058770002e-10
+#define LG1		6.666666666666735130e-01
+#define LG2		3.999999999940941908e-01
+#define LG3		2.857142874366239149e-01
+#define LG4		2.222219843214978396e-01
+#define LG5		1.818357216161805012e-01
+#define LG6		1.531383769920937332e-01
+#define LG7		1.479819860511658591e-01
+
+static const char * const _kernel_names[] = {
+	[LS_AUTO] = "auto",
+	[LS_SCALAR] = "scalar",
+	[LS_SSE2] = "sse2",
+	[LS_AVX2] = "avx2",
+	[LS_AVX512] = "avx512",
+	[LS_FREXP] = "frexp"
+};
+
+/**
+ * logsum_specials() - sum logs of values, which vector kernels skip.
+ * @arr:	array.
+ * @num:	number of elements, processed by vector loop.
+ */
+static double logsum_specials(const double *arr, long long num)
+{
+	double res = 0.;
+	for (long long i = 0; i < num; i++)
+		if (!(arr[i] >= DBL_MIN && arr[i] < INFINITY))
+			res += log(arr[i]);
+	return res;
+}
+
+static double logsum_scalar(const double *arr, long long num)
+{
+	double r = 0.;
+	for (long long i = 0; i < num; i++)
+		r += log(arr[i]);
+	return r;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#define LS_WIDTH	2
+#define LS_TARGET	__attribute__((target("sse2")))
+#define LS_POLY		logsum_sse2
+#define LS_FREXP	logsum_frexp_sse2
+#include "logsum_kernel.h"
+
+#define LS_WIDTH	4
+#define LS_TARGET	__attribute__((target("avx2,fma")))
+#define LS_POLY		logsum_avx2
+#define LS_FREXP	logsum_frexp_avx2
+#include "logsum_kernel.h"
+
+#define LS_WIDTH	8
+#define LS_TARGET	__attribute__((target("avx512f")))
+#define LS_POLY		logsum_avx512
+#define LS_FREXP	logsum_frexp_avx512
+#include "logsum_kernel.h"
+
+static bool has_avx2(void)
+{
+	return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+}
+
+static bool has_avx512(void)
+{
+	return __builtin_cpu_supports("avx512f");
+}
+#else
+/* Generic vectors only, compiler picks whatever the target has. Polynomial
+ * kernel is not dispatched here, only frexp one */
+#define LS_WIDTH	2
+#define LS_TARGET	__attribute__((unused))
+#define LS_POLY		logsum_generic
+#define LS_FREXP	logsum_frexp_generic
+#include "logsum_kernel.h"
+#endif
+
+enum logsum_kernel logsum_parse(const char *name)
+{
+	enum logsum_kernel k;
+	for (k = 0; k < LS_COUNT; k++)
+		if (!strcmp(name, _kernel_names[k]))
+			break;
+	return k;
+}
+
+const char *logsum_name(enum logsum_kernel kernel)
+{
+	return kernel < LS_COUNT ? _kernel_names[kernel] : "unknown";
+}
+
+enum logsum_kernel logsum_resolve(enum logsum_kernel kernel)
+{
+	if (LS_AUTO != kernel)
+		return kernel;
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_cpu_init();
+	if (has_avx512())
+		return LS_AVX512;
+	if (has_avx2())
+		return LS_AVX2;
+	return LS_SSE2;
+#else
+	return LS_SCALAR;
+#endif
+}
+
+logsum_fn logsum_get(enum logsum_kernel kernel)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_cpu_init();
+	switch (logsum_resolve(kernel)) {
+	case LS_SCALAR:
+		return &logsum_scalar;
+	case LS_SSE2:
+		return __builtin_cpu_supports("sse2") ? &logsum_sse2 : NULL;
+	case LS_AVX2:
+		return has_avx2() ? &logsum_avx2 : NULL;
+	case LS_AVX512:
+		return has_avx512() ? &logsum_avx512 : NULL;
+	case LS_FREXP:
+		if (has_avx512())
+			return &logsum_frexp_avx512;
+		if (has_avx2())
+			return &logsum_frexp_avx2;
+		return &logsum_frexp_sse2;
+	default:
+		return NULL;
+	}
+#else
+	switch (logsum_resolve(kernel)) {
+	case LS_SCALAR:
+		return &logsum_scalar;
+	case LS_FREXP:
+		return &logsum_frexp_generic;
+	default:
+		return NULL;
+	}
+#endif
+}
@@ -0,0 +1,44 @@
+#ifndef LOGSUM_H
+#define LOGSUM_H
+
+/* Kernels, which compute sum of natural logarithms of array */
+enum logsum_kernel {
+	LS_AUTO = 0,	/* Fastest exact kernel CPU supports */
+	LS_SCALAR,	/* libm log() for every element */
+	LS_SSE2,	/* Polynomial log, 2 lanes */
+	LS_AVX2,	/* Polynomial log, 4 lanes, FMA */
+	LS_AVX512,	/* Polynomial log, 8 lanes */
+	LS_FREXP,	/* log of product of mantissas + sum of exponents */
+	LS_COUNT
+};
+
+typedef double (*logsum_fn)(const double *arr, long long num);
+
+/**
+ * logsum_parse() - find kernel by its name.
+ * @name:	kernel name, as returned by logsum_name().
+ *
+ * Return: kernel or LS_COUNT if name is unknown.
+ */
+enum logsum_kernel logsum_parse(const char *name);
+
+/**
+ * logsum_name() - printable name of kernel.
+ */
+const char *logsum_name(enum logsum_kernel kernel);
+
+/**
+ * logsum_resolve() - replace LS_AUTO with the best kernel supported by CPU.
+ */
+enum logsum_kernel logsum_resolve(enum logsum_kernel kernel);
+
+/**
+ * logsum_get() - get kernel function.
+ * @kernel:	kernel. LS_AUTO is resolved.
+ *
+ * Uses runtime CPU detection.
+ * Return: function or NULL if CPU does not support kernel.
+ */
+logsum_fn logsum_get(enum logsum_kernel kernel);
+
+#endif /* LOGSUM_H */
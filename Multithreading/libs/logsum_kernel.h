@@ -0,0 +1,108 @@
+/*
+ * Template of vectorized log-sum kernels. Included by logsum.c once for every
+ * instruction set with following macros defined:
+ * LS_WIDTH	- number of doubles in vector
+ * LS_TARGET	- function attributes, e.g. __attribute__((target("avx2")))
+ * LS_POLY	- name of polynomial log kernel
+ * LS_FREXP	- name of mantissa product kernel
+ *
+ * Vector loops handle positive normal numbers only. Zero, subnormal, negative,
+ * inf and nan lanes are replaced with 1. (log is 0) and, if there were any,
+ * added by scalar pass at the end. They are rare, so loops have no branches.
+ */
+
+/*
+ * log(x) = k * ln2 + log(1 + f), where 1 + f is in [sqrt(2)/2; sqrt(2)).
+ * log(1 + f) is evaluated as in fdlibm e_log.c, error is below 1 ulp.
+ */
+LS_TARGET static double LS_POLY(const double *arr, long long num)
+{
+	typedef double vd __attribute__((vector_size(LS_WIDTH * sizeof(double))));
+	typedef unsigned long long vi __attribute__((vector_size(LS_WIDTH * sizeof(double))));
+	vd sum = {0}, x, m, f, s, z, w, r, k, hfsq;
+	vi bits, big, sp, special = {0};
+	long long i;
+	double res = 0.;
+
+	for (i = 0; i + LS_WIDTH <= num; i += LS_WIDTH) {
+		memcpy(&x, arr + i, sizeof x);
+		sp = (vi)(x < DBL_MIN) | ~(vi)(x < INFINITY);
+		special |= sp;
+		bits = ((vi)x & ~sp) | (EXP_ONE & sp);
+
+		m = (vd)((bits & MANT_MASK) | EXP_ONE);
+		k = (vd)((bits >> 52) | MAGIC_BITS) - (MAGIC + 1023.);
+		big = (vi)(m > SQRT2);
+		m = (vd)(((vi)(m * 0.5) & big) | ((vi)m & ~big));
+		k += (vd)(EXP_ONE & big);
+
+		f = m - 1.;
+		s = f / (2. + f);
+		z = s * s;
+		w = z * z;
+		r = z * (LG1 + w * (LG3 + w * (LG5 + w * LG7)))
+		    + w * (LG2 + w * (LG4 + w * LG6));
+		hfsq = 0.5 * f * f;
+		sum += k * LN2_HI - ((hfsq - (s * (hfsq + r) + k * LN2_LO)) - f);
+	}
+	for (int j = 0; j < LS_WIDTH; j++)
+		res += sum[j];
+	for (int j = 0; j < LS_WIDTH; j++) {
+		if (special[j]) {
+			res += logsum_specials(arr, i);
+			break;
+		}
+	}
+	for (; i < num; i++)
+		res += log(arr[i]);
+	return res;
+}
+
+/*
+ * sum(log(x)) = log(prod(m)) + ln2 * sum(e), where x = m * 2^e, m in [0.5; 1).
+ * Product of 512 mantissas is above 2^-512, so it is renormalized every
+ * 512 vectors and only one log() per lane is called in the end.
+ */
+LS_TARGET static double LS_FREXP(const double *arr, long long num)
+{
+	typedef double vd __attribute__((vector_size(LS_WIDTH * sizeof(double))));
+	typedef unsigned long long vi __attribute__((vector_size(LS_WIDTH * sizeof(double))));
+	vd prod = {0}, exps = {0}, x;
+	vi bits, sp, special = {0};
+	long long i = 0;
+	double res = 0.;
+
+	prod += 1.;
+	while (i + LS_WIDTH <= num) {
+		for (int blk = 0; blk < 512 && i + LS_WIDTH <= num;
+		     blk++, i += LS_WIDTH) {
+			memcpy(&x, arr + i, sizeof x);
+			sp = (vi)(x < DBL_MIN) | ~(vi)(x < INFINITY);
+			special |= sp;
+			bits = ((vi)x & ~sp) | (EXP_ONE & sp);
+
+			exps += (vd)((bits >> 52) | MAGIC_BITS)
+				- (MAGIC + 1022.);
+			prod *= (vd)((bits & MANT_MASK) | EXP_HALF);
+		}
+		bits = (vi)prod;
+		exps += (vd)((bits >> 52) | MAGIC_BITS) - (MAGIC + 1022.);
+		prod = (vd)((bits & MANT_MASK) | EXP_HALF);
+	}
+	for (int j = 0; j < LS_WIDTH; j++)
+		res += log(prod[j]) + exps[j] * LN2;
+	for (int j = 0; j < LS_WIDTH; j++) {
+		if (special[j]) {
+			res += logsum_specials(arr, i);
+			break;
+		}
+	}
+	for (; i < num; i++)
+		res += log(arr[i]);
+	return res;
+}
+
+#undef LS_WIDTH
+#undef LS_TARGET
+#undef LS_POLY
+#undef LS_FREXP
@@ -0,0 +1,369 @@
+#include "mapreduce.h"
+
+#include <string.h>
+#include <math.h>
+#include <dlfcn.h>
+
+/* Independent accumulators in sum, min and max loops. Lets compiler keep
+ * them in vector registers without reassociating floating point math */
+#define MR_LANES 8
+
+/* Elements mapped by user function at once */
+#define MR_USER_BLOCK 1024
+
+static const char * const _map_names[] = {
+	[MR_LOG] = "log",
+	[MR_SQRT] = "sqrt",
+	[MR_IDENTITY] = "identity",
+	[MR_SQUARE] = "square",
+	[MR_USER] = "user"
+};
+
+static const char * const _reduce_names[] = {
+	[MR_SUM] = "sum",
+	[MR_MIN] = "min",
+	[MR_MAX] = "max",
+	[MR_KAHAN] = "kahan",
+	[MR_HIST] = "hist"
+};
+
+/*
+ * Maps. They are passed to reduce templates as constants, so after
+ * always_inline templates are expanded, calls are inlined too.
+ */
+static inline double map_log(double x)
+{
+	return log(x);
+}
+
+static inline double map_sqrt(double x)
+{
+	return sqrt(x);
+}
+
+static inline double map_identity(double x)
+{
+	return x;
+}
+
+static inline double map_square(double x)
+{
+	return x * x;
+}
+
+#define MR_INLINE static inline __attribute__((always_inline))
+
+/* Reduce templates */
+MR_INLINE void reduce_sum(const struct mr_op *op, double (*map)(double),
+			  const double *arr, long long num, struct mr_acc *acc)
+{
+	double lane[MR_LANES] = {0};
+	long long i;
+
+	(void)op;
+	for (i = 0; i + MR_LANES <= num; i += MR_LANES)
+		for (int j = 0; j < MR_LANES; j++)
+			lane[j] += map(arr[i + j]);
+	for (; i < num; i++)
+		lane[0] += map(arr[i]);
+	for (int j = 0; j < MR_LANES; j++)
+		acc->sum += lane[j];
+}
+
+MR_INLINE void reduce_min(const struct mr_op *op, double (*map)(double),
+			  const double *arr, long long num, struct mr_acc *acc)
+{
+	double lane[MR_LANES], y;
+	long long i;
+
+	(void)op;
+	for (int j = 0; j < MR_LANES; j++)
+		lane[j] = acc->min;
+	for (i = 0; i + MR_LANES <= num; i += MR_LANES)
+		for (int j = 0; j < MR_LANES; j++) {
+			y = map(arr[i + j]);
+			lane[j] = y < lane[j] ? y : lane[j];
+		}
+	for (; i < num; i++) {
+		y = map(arr[i]);
+		lane[0] = y < lane[0] ? y : lane[0];
+	}
+	for (int j = 0; j < MR_LANES; j++)
+		acc->min = lane[j] < acc->min ? lane[j] : acc->min;
+}
+
+MR_INLINE void reduce_max(const struct mr_op *op, double (*map)(double),
+			  const double *arr, long long num, struct mr_acc *acc)
+{
+	double lane[MR_LANES], y;
+	long long i;
+
+	(void)op;
+	for (int j = 0; j < MR_LANES; j++)
+		lane[j] = acc->max;
+	for (i = 0; i + MR_LANES <= num; i += MR_LANES)
+		for (int j = 0; j < MR_LANES; j++) {
+			y = map(arr[i + j]);
+			lane[j] = y > lane[j] ? y : lane[j];
+		}
+	for (; i < num; i++) {
+		y = map(arr[i]);
+		lane[0] = y > lane[0] ? y : lane[0];
+	}
+	for (int j = 0; j < MR_LANES; j++)
+		acc->max = lane[j] > acc->max ? lane[j] : acc->max;
+}
+
+/* Kahan summation. Order matters here, so loop is sequential */
+MR_INLINE void kahan_add(struct mr_acc *acc, double y)
+{
+	double t;
+
+	y -= acc->comp;
+	t = acc->sum + y;
+	acc->comp = (t - acc->sum) - y;
+	acc->sum = t;
+}
+
+MR_INLINE void reduce_kahan(const struct mr_op *op, double (*map)(double),
+			    const double *arr, long long num, struct mr_acc *acc)
+{
+	(void)op;
+	for (long long i = 0; i < num; i++)
+		kahan_add(acc, map(arr[i]));
+}
+
+MR_INLINE void reduce_hist(const struct mr_op *op, double (*map)(double),
+			   const double *arr, long long num, struct mr_acc *acc)
+{
+	double scale = MR_HIST_BINS / (op->hi - op->lo), y;
+	int bin;
+
+	for (long long i = 0; i < num; i++) {
+		y = map(arr[i]);
+		if (y < op->lo)
+			bin = 0;
+		else if (y < op->hi)
+			bin = 1 + (int)((y - op->lo) * scale);
+		else
+			bin = MR_HIST_BINS + 1;
+		/* rounding can put y close to hi into the last bin + 1 */
+		if (bin > MR_HIST_BINS && y < op->hi)
+			bin = MR_HIST_BINS;
+		acc->hist[bin]++;
+	}
+}
+
+/* Instantiate kernel for every map and reduce */
+#define MR_KERNEL(m, r)							\
+static void kernel_##m##_##r(const struct mr_op *op, const double *arr,	\
+			     long long num, struct mr_acc *acc)		\
+{									\
+	reduce_##r(op, map_##m, arr, num, acc);				\
+}
+
+/* User map is called on blocks of elements, then reduce is inlined */
+#define MR_USER_KERNEL(r)						\
+static void kernel_user_##r(const struct mr_op *op, const double *arr,	\
+			    long long num, struct mr_acc *acc)		\
+{									\
+	double buf[MR_USER_BLOCK];					\
+	for (long long i = 0; i < num; i += MR_USER_BLOCK) {		\
+		long long n = num - i < MR_USER_BLOCK ?			\
+			      num - i : MR_USER_BLOCK;			\
+		memcpy(buf, arr + i, n * sizeof *buf);			\
+		op->user(buf, n);					\
+		reduce_##r(op, map_identity, buf, n, acc);		\
+	}								\
+}
+
+#define MR_KERNELS(r)							\
+	MR_KERNEL(log, r)						\
+	MR_KERNEL(sqrt, r)						\
+	MR_KERNEL(identity, r)						\
+	MR_KERNEL(square, r)						\
+	MR_USER_KERNEL(r)
+
+MR_KERNELS(sum)
+MR_KERNELS(min)
+MR_KERNELS(max)
+MR_KERNELS(kahan)
+MR_KERNELS(hist)
+
+#define MR_ROW(r) {							\
+	[MR_LOG] = kernel_log_##r,					\
+	[MR_SQRT] = kernel_sqrt_##r,					\
+	[MR_IDENTITY] = kernel_identity_##r,				\
+	[MR_SQUARE] = kernel_square_##r,				\
+	[MR_USER] = kernel_user_##r					\
+}
+
+static const mr_kernel_fn _kernels[MR_REDUCE_COUNT][MR_MAP_COUNT] = {
+	[MR_SUM] = MR_ROW(sum),
+	[MR_MIN] = MR_ROW(min),
+	[MR_MAX] = MR_ROW(max),
+	[MR_KAHAN] = MR_ROW(kahan),
+	[MR_HIST] = MR_ROW(hist)
+};
+
+/* log + sum has its own vectorized kernels with runtime dispatch */
+static void kernel_logsum(const struct mr_op *op, const double *arr,
+			  long long num, struct mr_acc *acc)
+{
+	acc->sum += op->logsum(arr, num);
+}
+
+enum mr_map mr_parse_map(const char *name)
+{
+	enum mr_map m;
+	for (m = 0; m < MR_USER; m++)
+		if (!strcmp(name, _map_names[m]))
+			break;
+	return m;
+}
+
+enum mr_reduce mr_parse_reduce(const char *name)
+{
+	enum mr_reduce r;
+	for (r = 0; r < MR_REDUCE_COUNT; r++)
+		if (!strcmp(name, _reduce_names[r]))
+			break;
+	return r;
+}
+
+const char *mr_map_name(enum mr_map map)
+{
+	return map < MR_MAP_COUNT ? _map_names[map] : "unknown";
+}
+
+const char *mr_reduce_name(enum mr_reduce reduce)
+{
+	return reduce < MR_REDUCE_COUNT ? _reduce_names[reduce] : "unknown";
+}
+
+int mr_op_init(struct mr_op *op, const char *path)
+{
+	op->dl = NULL;
+	op->user = NULL;
+	if (MR_USER == op->map) {
+		op->dl = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+		if (NULL == op->dl)
+			return -1;
+		/* Cast through void * is the way dlsym() is meant to be used */
+		*(void **)&op->user = dlsym(op->dl, "map_block");
+		if (NULL == op->user) {
+			dlclose(op->dl);
+			op->dl = NULL;
+			return -1;
+		}
+	}
+	if (MR_LOG == op->map && MR_SUM == op->reduce && NULL != op->logsum)
+		op->kernel = kernel_logsum;
+	else
+		op->kernel = _kernels[op->reduce][op->map];
+	return 0;
+}
+
+void mr_op_destroy(struct mr_op *op)
+{
+	if (NULL != op->dl)
+		dlclose(op->dl);
+	op->dl = NULL;
+}
+
+void mr_acc_init(struct mr_acc *acc)
+{
+	acc->sum = acc->comp = 0.;
+	acc->min = INFINITY;
+	acc->max = -INFINITY;
+	for (int i = 0; i < MR_HIST_BINS + 2; i++)
+		acc->hist[i] = 0;
+}
+
+void mr_combine(const struct mr_op *op, struct mr_acc *dst, const struct mr_acc *src)
+{
+	switch (op->reduce) {
+	case MR_SUM:
+		dst->sum += src->sum;
+		break;
+	case MR_MIN:
+		dst->min = src->min < dst->min ? src->min : dst->min;
+		break;
+	case MR_MAX:
+		dst->max = src->max > dst->max ? src->max : dst->max;
+		break;
+	case MR_KAHAN:
+		kahan_add(dst, src->sum);
+		kahan_add(dst, -src->comp);
+		break;
+	case MR_HIST:
+		for (int i = 0; i < MR_HIST_BINS + 2; i++)
+			dst->hist[i] += src->hist[i];
+		break;
+	default:
+		break;
+	}
+}
+
+/**
+ * atomic_update() - replace shared double with f(old, val) without lock.
+ *
+ * There is no fetch_add for doubles, so compare-and-swap loop is used.
+ */
+#define atomic_update(ptr, val, expr) do {				\
+	double old, new, v = (val);					\
+	__atomic_load((ptr), &old, __ATOMIC_RELAXED);			\
+	do {								\
+		new = (expr);						\
+	} while (!__atomic_compare_exchange((ptr), &old, &new, true,	\
+					    __ATOMIC_RELAXED,		\
+					    __ATOMIC_RELAXED));		\
+	} while (0)
+
+void mr_combine_atomic(const struct mr_op *op, struct mr_acc *dst, const struct mr_acc *src)
+{
+	switch (op->reduce) {
+	case MR_SUM:
+		atomic_update(&dst->sum, src->sum, old + v);
+		break;
+	case MR_KAHAN:
+		atomic_update(&dst->sum, src->sum - src->comp, old + v);
+		break;
+	case MR_MIN:
+		atomic_update(&dst->min, src->min, v < old ? v : old);
+		break;
+	case MR_MAX:
+		atomic_update(&dst->max, src->max, v > old ? v : old);
+		break;
+	case MR_HIST:
+		for (int i = 0; i < MR_HIST_BINS + 2; i++)
+			if (src->hist[i])
+				__atomic_fetch_add(&dst->hist[i], src->hist[i],
+						   __ATOMIC_RELAXED);
+		break;
+	default:
+		break;
+	}
+}
+
+double mr_value(const struct mr_op *op, const struct mr_acc *acc)
+{
+	long long inside = 0;
+
+	switch (op->reduce) {
+	case MR_SUM:
+		return acc->sum;
+	case MR_KAHAN:
+		return acc->sum - acc->comp;
+	case MR_MIN:
+		return acc->min;
+	case MR_MAX:
+		return acc->max;
+	case MR_HIST:
+		for (int i = 1; i <= MR_HIST_BINS; i++)
+			inside += acc->hist[i];
+		return inside;
+	default:
+		return NAN;
+	}
+}
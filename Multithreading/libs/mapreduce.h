@@ -0,0 +1,135 @@
+#ifndef MAPREDUCE_H
+#define MAPREDUCE_H
+
+#include <stdbool.h>
+
+#include "logsum.h"
+
+/* Bins of histogram between lo and hi. Two more count values out of range */
+#define MR_HIST_BINS 16
+
+/* Function applied to every element */
+enum mr_map {
+	MR_LOG = 0,
+	MR_SQRT,
+	MR_IDENTITY,
+	MR_SQUARE,
+	MR_USER,	/* map_block() from shared object */
+	MR_MAP_COUNT
+};
+
+/* How mapped elements are combined */
+enum mr_reduce {
+	MR_SUM = 0,
+	MR_MIN,
+	MR_MAX,
+	MR_KAHAN,	/* compensated sum */
+	MR_HIST,
+	MR_REDUCE_COUNT
+};
+
+/**
+ * typedef mr_user_fn - map, loaded from shared object. Has to be exported
+ * as "map_block" and map buffer in place.
+ * @buf:	values to map.
+ * @num:	number of values.
+ */
+typedef void (*mr_user_fn)(double *buf, long long num);
+
+/**
+ * struct mr_acc - partial result. Every field is used by some reduce.
+ * @sum:	sum (MR_SUM, MR_KAHAN).
+ * @comp:	Kahan compensation, true sum is sum - comp (MR_KAHAN).
+ * @min:	minimum (MR_MIN).
+ * @max:	maximum (MR_MAX).
+ * @hist:	[0] - below lo, [1..MR_HIST_BINS] - bins,
+ *		[MR_HIST_BINS + 1] - at or above hi, and nan (MR_HIST).
+ */
+struct mr_acc {
+	double sum, comp;
+	double min, max;
+	long long hist[MR_HIST_BINS + 2];
+};
+
+struct mr_op;
+
+typedef void (*mr_kernel_fn)(const struct mr_op *op, const double *arr,
+			     long long num, struct mr_acc *acc);
+
+/**
+ * struct mr_op - composed map-reduce operator.
+ * @map:	map.
+ * @reduce:	reduce.
+ * @lo:		lower bound of histogram.
+ * @hi:		upper bound of histogram.
+ * @logsum:	vectorized kernel for MR_LOG + MR_SUM.
+ * @user:	map for MR_USER.
+ * @dl:		handle of shared object with user map.
+ * @kernel:	loop over chunk, map and reduce are inlined into it.
+ */
+struct mr_op {
+	enum mr_map map;
+	enum mr_reduce reduce;
+	double lo, hi;
+	logsum_fn logsum;
+	mr_user_fn user;
+	void *dl;
+	mr_kernel_fn kernel;
+};
+
+/**
+ * mr_parse_map() - find map by name.
+ *
+ * Return: map or MR_USER if name is not known, so it is treated as path to
+ * shared object.
+ */
+enum mr_map mr_parse_map(const char *name);
+
+/**
+ * mr_parse_reduce() - find reduce by name.
+ *
+ * Return: reduce or MR_REDUCE_COUNT if name is unknown.
+ */
+enum mr_reduce mr_parse_reduce(const char *name);
+
+const char *mr_map_name(enum mr_map map);
+const char *mr_reduce_name(enum mr_reduce reduce);
+
+/**
+ * mr_op_init() - compose operator.
+ * @op:		operator. map, reduce, lo, hi and logsum are to be set by caller.
+ * @path:	shared object for MR_USER, NULL otherwise.
+ *
+ * Return: 0 or -1 if shared object can't be loaded.
+ */
+int mr_op_init(struct mr_op *op, const char *path);
+
+/**
+ * mr_op_destroy() - unload shared object, if any.
+ */
+void mr_op_destroy(struct mr_op *op);
+
+/**
+ * mr_acc_init() - make empty partial result.
+ */
+void mr_acc_init(struct mr_acc *acc);
+
+/**
+ * mr_combine() - add partial result src to dst.
+ */
+void mr_combine(const struct mr_op *op, struct mr_acc *dst, const struct mr_acc *src);
+
+/**
+ * mr_combine_atomic() - add partial result src to shared dst without lock.
+ *
+ * Kahan compensation of src is applied before, so dst gets plain sum.
+ */
+void mr_combine_atomic(const struct mr_op *op, struct mr_acc *dst, const struct mr_acc *src);
+
+/**
+ * mr_value() - scalar result: sum, min or max. For histogram - number of
+ * values inside [lo; hi).
+ */
+double mr_value(const struct mr_op *op, const struct mr_acc *acc);
+
+#endif /* MAPREDUCE_H */
@@ -0,0 +1,185 @@
+#include "node.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+
+/**
+ * parse_cpulist() - parse list like "0-3,8,10-11" into set.
+ *
+ * Return: number of CPUs or -1 if file can't be read.
+ */
+static int parse_cpulist(const char *path, cpu_set_t *set)
+{
+	FILE *fp = fopen(path, "r");
+	int lo, hi, num = 0;
+	char sep;
+
+	CPU_ZERO(set);
+	if (NULL == fp)
+		return -1;
+	while (fscanf(fp, "%d", &lo) == 1) {
+		hi = lo;
+		sep = fgetc(fp);
+		if ('-' == sep) {
+			if (fscanf(fp, "%d", &hi) != 1)
+				break;
+			sep = fgetc(fp);
+		}
+		for (int cpu = lo; cpu <= hi && cpu < CPU_SETSIZE; cpu++) {
+			CPU_SET(cpu, set);
+			num++;
+		}
+		if (',' != sep)
+			break;
+	}
+	fclose(fp);
+	return num;
+}
+
+int node_count(void)
+{
+	cpu_set_t set;
+	int res = 0;
+
+	/* The same format as cpulist, but with nodes */
+	if (parse_cpulist("/sys/devices/system/node/online", &set) <= 0)
+		return 1;
+	for (int i = 0; i < CPU_SETSIZE; i++)
+		if (CPU_ISSET(i, &set))
+			res = i + 1;
+	return res;
+}
+
+int node_cpus(int node, cpu_set_t *set)
+{
+	char path[64];
+	int num;
+
+	snprintf(path, sizeof path, "/sys/devices/system/node/node%d/cpulist", node);
+	num = parse_cpulist(path, set);
+	if (num >= 0)
+		return num;
+	/* No NUMA in system: everything is node 0 */
+	CPU_ZERO(set);
+	if (node)
+		return 0;
+	num = sysconf(_SC_NPROCESSORS_ONLN);
+	for (int cpu = 0; cpu < num && cpu < CPU_SETSIZE; cpu++)
+		CPU_SET(cpu, set);
+	return num;
+}
+
+int node_nth_cpu(int node, int n)
+{
+	cpu_set_t set;
+	int num = node_cpus(node, &set);
+
+	if (num <= 0)
+		return -1;
+	n %= num;
+	for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+		if (CPU_ISSET(cpu, &set) && 0 == n--)
+			return cpu;
+	return -1;
+}
+
+int node_bind(void *addr, size_t len, int node)
+{
+	uintptr_t page = sysconf(_SC_PAGESIZE);
+	uintptr_t start = ((uintptr_t)addr + page - 1) & ~(page - 1);
+	uintptr_t end = ((uintptr_t)addr + len) & ~(page - 1);
+	unsigned long mask[(node + 8 * sizeof(unsigned long)) / (8 * sizeof(unsigned long))];
+
+	if (end <= start)
+		return 0;
+	for (size_t i = 0; i < sizeof mask / sizeof *mask; i++)
+		mask[i] = 0;
+	mask[node / (8 * sizeof(unsigned long))] |= 1UL << (node % (8 * sizeof(unsigned long)));
+	return syscall(SYS_mbind, start, end - start, MPOL_PREFERRED, mask,
+		       8 * sizeof mask + 1, 0);
+}
+
+/* Place of CPU in topology */
+struct cpu_topo {
+	int cpu;
+	int package;
+	int core;
+	int smt;	/* index among hardware threads of core */
+};
+
+/* Reads single integer from sysfs file, def if there's none */
+static int read_topo(int cpu, const char *name, int def)
+{
+	char path[96];
+	FILE *fp;
+	int val;
+
+	snprintf(path, sizeof path,
+		 "/sys/devices/system/cpu/cpu%d/topology/%s", cpu, name);
+	fp = fopen(path, "r");
+	if (NULL == fp)
+		return def;
+	if (fscanf(fp, "%d", &val) != 1)
+		val = def;
+	fclose(fp);
+	return val;
+}
+
+#define CMP(a, b)	(((a) > (b)) - ((a) < (b)))
+
+static int cmp_compact(const void *pa, const void *pb)
+{
+	const struct cpu_topo *a = pa, *b = pb;
+	if (a->package != b->package)
+		return CMP(a->package, b->package);
+	if (a->core != b->core)
+		return CMP(a->core, b->core);
+	return CMP(a->smt, b->smt);
+}
+
+static int cmp_scatter(const void *pa, const void *pb)
+{
+	const struct cpu_topo *a = pa, *b = pb;
+	if (a->smt != b->smt)
+		return CMP(a->smt, b->smt);
+	if (a->core != b->core)
+		return CMP(a->core, b->core);
+	return CMP(a->package, b->package);
+}
+
+int node_cpu_order(enum cpu_order order, int *cpus, int max)
+{
+	cpu_set_t allowed;
+	struct cpu_topo *topo;
+	int num = 0, res = 0;
+
+	if (sched_getaffinity(0, sizeof allowed, &allowed) < 0)
+		return 0;
+	topo = malloc(CPU_COUNT(&allowed) * sizeof *topo);
+	if (NULL == topo)
+		return 0;
+	for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+		if (!CPU_ISSET(cpu, &allowed))
+			continue;
+		struct cpu_topo *t = &topo[num++];
+		t->cpu = cpu;
+		t->package = read_topo(cpu, "physical_package_id", 0);
+		t->core = read_topo(cpu, "core_id", cpu);
+		t->smt = 0;
+		/* CPUs go in ascending order, so siblings before are counted */
+		for (struct cpu_topo *o = topo; o < t; o++)
+			if (o->package == t->package && o->core == t->core)
+				t->smt++;
+	}
+	qsort(topo, num, sizeof *topo,
+	      CO_SCATTER == order ? cmp_scatter : cmp_compact);
+	for (int i = 0; i < num && res < max; i++)
+		if (CO_PHYSICAL != order || 0 == topo[i].smt)
+			cpus[res++] = topo[i].cpu;
+	free(topo);
+	return res;
+}
@@ -0,0 +1,72 @@
+#ifndef NODE_H
+#define NODE_H
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <stddef.h>
+#include <sched.h>
+
+/*
+ * NUMA topology from sysfs and memory binding with raw mbind() syscall,
+ * so libnuma is not needed. Without NUMA, the system is a single node 0
+ * with all online CPUs.
+ */
+
+/**
+ * node_count() - number of NUMA nodes (max online node + 1).
+ */
+int node_count(void);
+
+/**
+ * node_cpus() - CPUs of node.
+ * @node:	node index.
+ * @set:	where to store CPUs.
+ *
+ * Return: number of CPUs in set.
+ */
+int node_cpus(int node, cpu_set_t *set);
+
+/**
+ * node_nth_cpu() - n-th CPU of node, counting cyclically.
+ *
+ * Return: CPU index or -1 if node has no CPUs.
+ */
+int node_nth_cpu(int node, int n);
+
+/**
+ * node_bind() - make pages of memory range prefer node.
+ * @addr:	start of range.
+ * @len:	length of range in bytes.
+ * @node:	node index.
+ *
+ * Only pages, which lie inside range completely, are bound, so ranges of
+ * neighbour threads don't fight over shared page. Has to be called before
+ * pages are touched first time. Preferred policy falls back to other nodes
+ * when node is out of memory.
+ *
+ * Return: 0 or -1 with errno set.
+ */
+int node_bind(void *addr, size_t len, int node);
+
+/* Order of CPUs for placement of threads */
+enum cpu_order {
+	CO_COMPACT = 0,	/* hardware threads of core, then cores of package */
+	CO_SCATTER,	/* next package first, SMT siblings last */
+	CO_PHYSICAL,	/* first hardware thread of every core only */
+	CO_COUNT
+};
+
+/**
+ * node_cpu_order() - list CPUs, which process is allowed to use, in order.
+ * @order:	order of CPUs.
+ * @cpus:	where to store CPU indexes.
+ * @max:	size of cpus.
+ *
+ * Topology is read from /sys/devices/system/cpu/cpuN/topology. Without it
+ * every CPU is a core of its own in package 0.
+ * Return: number of CPUs stored.
+ */
+int node_cpu_order(enum cpu_order order, int *cpus, int max);
+
+#endif /* NODE_H */
@@ -0,0 +1,106 @@
+#include "perf.h"
+
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+static const char * const _counter_names[] = {
+	[PC_CYCLES] = "cycles",
+	[PC_INSTRUCTIONS] = "instructions",
+	[PC_LLC_MISSES] = "llc-misses",
+	[PC_BRANCH_MISSES] = "branch-misses",
+	[PC_CTX_SWITCHES] = "ctx-switches"
+};
+
+static const struct {
+	unsigned type;
+	unsigned long long config;
+} _events[] = {
+	[PC_CYCLES] = {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+	[PC_INSTRUCTIONS] = {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+	[PC_LLC_MISSES] = {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+	[PC_BRANCH_MISSES] = {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+	[PC_CTX_SWITCHES] = {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES}
+};
+
+/* glibc has no wrapper for this syscall */
+static int perf_event_open(struct perf_event_attr *attr, pid_t tid)
+{
+	return syscall(SYS_perf_event_open, attr, tid, -1, -1, 0);
+}
+
+int perf_open(struct perf_set *set, pid_t tid)
+{
+	struct perf_event_attr attr;
+	int num = 0;
+
+	for (int i = 0; i < PC_COUNT; i++) {
+		memset(&attr, 0, sizeof attr);
+		attr.size = sizeof attr;
+		attr.type = _events[i].type;
+		attr.config = _events[i].config;
+		attr.disabled = 1;
+		/*
+		 * Hardware counters count user space only, so perf_event_paranoid
+		 * 2 is enough. Software ones are counted by kernel, context
+		 * switches with exclude_kernel would always read 0.
+		 */
+		if (PERF_TYPE_HARDWARE == attr.type) {
+			attr.exclude_kernel = 1;
+			attr.exclude_hv = 1;
+		}
+		attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED |
+				   PERF_FORMAT_TOTAL_TIME_RUNNING;
+		set->fd[i] = perf_event_open(&attr, tid);
+		set->value[i] = -1;
+		if (set->fd[i] >= 0)
+			num++;
+	}
+	return num;
+}
+
+void perf_start(struct perf_set *set)
+{
+	for (int i = 0; i < PC_COUNT; i++) {
+		if (set->fd[i] < 0)
+			continue;
+		ioctl(set->fd[i], PERF_EVENT_IOC_RESET, 0);
+		ioctl(set->fd[i], PERF_EVENT_IOC_ENABLE, 0);
+	}
+}
+
+void perf_stop(struct perf_set *set)
+{
+	/* value, time enabled, time running */
+	unsigned long long buf[3];
+
+	for (int i = 0; i < PC_COUNT; i++) {
+		if (set->fd[i] < 0)
+			continue;
+		ioctl(set->fd[i], PERF_EVENT_IOC_DISABLE, 0);
+		if (read(set->fd[i], buf, sizeof buf) != sizeof buf) {
+			set->value[i] = -1;
+			continue;
+		}
+		/* Counter shared hardware with others part of time */
+		if (buf[2] && buf[2] < buf[1])
+			buf[0] = (double)buf[0] * buf[1] / buf[2];
+		set->value[i] = buf[0];
+	}
+}
+
+void perf_close(struct perf_set *set)
+{
+	for (int i = 0; i < PC_COUNT; i++) {
+		if (set->fd[i] >= 0)
+			close(set->fd[i]);
+		set->fd[i] = -1;
+	}
+}
+
+const char *perf_name(enum perf_counter pc)
+{
+	return pc < PC_COUNT ? _counter_names[pc] : "unknown";
+}
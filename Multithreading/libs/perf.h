@@ -0,0 +1,63 @@
+#ifndef PERF_H
+#define PERF_H
+
+#include <stdbool.h>
+#include <sys/types.h>
+
+/*
+ * Hardware and software counters of one thread with perf_event_open().
+ * Every counter is opened on its own, so the ones kernel or CPU does not
+ * support (e.g. in virtual machine or with perf_event_paranoid > 2) are
+ * just left out.
+ */
+
+enum perf_counter {
+	PC_CYCLES = 0,
+	PC_INSTRUCTIONS,
+	PC_LLC_MISSES,
+	PC_BRANCH_MISSES,
+	PC_CTX_SWITCHES,
+	PC_COUNT
+};
+
+/**
+ * struct perf_set - counters of one thread.
+ * @fd:		descriptors of counters, -1 if counter is unavailable.
+ * @value:	values after the last perf_stop(), scaled if counter was
+ *		multiplexed. -1 if counter is unavailable.
+ */
+struct perf_set {
+	int fd[PC_COUNT];
+	long long value[PC_COUNT];
+};
+
+/**
+ * perf_open() - open disabled counters for thread.
+ * @set:	counters to initialize.
+ * @tid:	kernel thread id, 0 for calling thread.
+ *
+ * Return: number of counters opened, 0 if none is available.
+ */
+int perf_open(struct perf_set *set, pid_t tid);
+
+/**
+ * perf_start() - reset and enable counters.
+ */
+void perf_start(struct perf_set *set);
+
+/**
+ * perf_stop() - disable counters and read their values into set->value.
+ */
+void perf_stop(struct perf_set *set);
+
+/**
+ * perf_close() - close counters. Values are kept.
+ */
+void perf_close(struct perf_set *set);
+
+/**
+ * perf_name() - short name of counter.
+ */
+const char *perf_name(enum perf_counter pc);
+
+#endif /* PERF_H */
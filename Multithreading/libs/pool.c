@@ -0,0 +1,211 @@
+#include "pool.h"
+
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#define DEQUE(first, end)	((unsigned long long)(first) | \
+				 (unsigned long long)(end) << 32)
+#define DEQUE_FIRST(deque)	((long long)((deque) & 0xFFFFFFFFULL))
+#define DEQUE_END(deque)	((long long)((deque) >> 32))
+
+/**
+ * deque_take() - take one chunk from deque of worker.
+ * @w:		worker, which owns deque.
+ * @back:	false - owner takes from the front, true - thief takes from back.
+ *
+ * Both ends are in one word, so single compare-and-swap is enough.
+ * Return: chunk index or -1 if deque is empty.
+ */
+static long long deque_take(struct pool_worker *w, bool back)
+{
+	unsigned long long old, new;
+	long long first, end;
+
+	old = __atomic_load_n(&w->deque, __ATOMIC_RELAXED);
+	do {
+		first = DEQUE_FIRST(old);
+		end = DEQUE_END(old);
+		if (first >= end)
+			return -1;
+		new = back ? DEQUE(first, end - 1) : DEQUE(first + 1, end);
+	} while (!__atomic_compare_exchange_n(&w->deque, &old, new, true,
+					      __ATOMIC_ACQ_REL,
+					      __ATOMIC_RELAXED));
+	return back ? end - 1 : first;
+}
+
+static void run_chunk(struct pool_worker *w, long long chunk)
+{
+	struct pool *p = w->pool;
+	long long begin = chunk * p->chunk_size;
+	long long end = begin + p->chunk_size;
+
+	if (end > p->num_items)
+		end = p->num_items;
+	p->func(p->ctx, w->id, begin, end);
+	w->chunks++;
+}
+
+/**
+ * steal() - steal all chunks available from workers of one kind.
+ * @w:		thief.
+ * @local:	true - steal from own domain only, false - from others only.
+ *
+ * Return: true if anything was stolen.
+ */
+static bool steal(struct pool_worker *w, bool local)
+{
+	struct pool *p = w->pool;
+	long long chunk;
+	bool found = false;
+
+	for (int i = 1; i < p->num_workers; i++) {
+		struct pool_worker *victim =
+			&p->workers[(w->id + i) % p->num_workers];
+		if ((victim->domain == w->domain) != local)
+			continue;
+		while ((chunk = deque_take(victim, true)) >= 0) {
+			run_chunk(w, chunk);
+			w->stolen++;
+			found = true;
+		}
+	}
+	return found;
+}
+
+/* Runs own chunks first, then steals until all deques are empty */
+static void run_job(struct pool_worker *w)
+{
+	long long chunk;
+
+	w->chunks = w->stolen = 0;
+	while ((chunk = deque_take(w, false)) >= 0)
+		run_chunk(w, chunk);
+	while (steal(w, true) || steal(w, false))
+		;
+}
+
+static void *worker_main(void *args)
+{
+	struct pool_worker *w = args;
+	struct pool *p = w->pool;
+	unsigned long seen = 0;
+
+	/* Let pool_create() know, that thread is ready */
+	pthread_mutex_lock(&p->lock);
+	w->tid = syscall(SYS_gettid);
+	pthread_cond_broadcast(&p->done);
+	pthread_mutex_unlock(&p->lock);
+
+	for (;;) {
+		pthread_mutex_lock(&p->lock);
+		while (p->generation == seen && !p->stop)
+			pthread_cond_wait(&p->start, &p->lock);
+		if (p->stop) {
+			pthread_mutex_unlock(&p->lock);
+			break;
+		}
+		seen = p->generation;
+		pthread_mutex_unlock(&p->lock);
+
+		clock_gettime(CLOCK_MONOTONIC_RAW, &w->start_time);
+		run_job(w);
+		clock_gettime(CLOCK_MONOTONIC_RAW, &w->end_time);
+
+		pthread_mutex_lock(&p->lock);
+		if (0 == --p->running)
+			pthread_cond_signal(&p->done);
+		pthread_mutex_unlock(&p->lock);
+	}
+	return NULL;
+}
+
+int pool_create(struct pool *pool, int num_workers, const pthread_attr_t *attr)
+{
+	int ret;
+
+	pool->workers = aligned_alloc(POOL_CACHE_LINE,
+				      num_workers * sizeof *pool->workers);
+	if (NULL == pool->workers)
+		return ENOMEM;
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->start, NULL);
+	pthread_cond_init(&pool->done, NULL);
+	pool->generation = 0;
+	pool->running = 0;
+	pool->stop = false;
+	pool->num_workers = 0;
+
+	for (int i = 0; i < num_workers; i++) {
+		struct pool_worker *w = &pool->workers[i];
+		w->deque = DEQUE(0, 0);
+		w->pool = pool;
+		w->id = i;
+		w->domain = 0;
+		w->chunks = w->stolen = 0;
+		w->tid = 0;
+		ret = pthread_create(&w->thread, attr, &worker_main, w);
+		if (ret) {
+			pool_destroy(pool);
+			return ret;
+		}
+		pool->num_workers++;
+	}
+
+	/* Wait for kernel thread ids, so caller can use them right away */
+	pthread_mutex_lock(&pool->lock);
+	for (int i = 0; i < num_workers; i++)
+		while (0 == pool->workers[i].tid)
+			pthread_cond_wait(&pool->done, &pool->lock);
+	pthread_mutex_unlock(&pool->lock);
+	return 0;
+}
+
+void pool_destroy(struct pool *pool)
+{
+	pthread_mutex_lock(&pool->lock);
+	pool->stop = true;
+	pthread_cond_broadcast(&pool->start);
+	pthread_mutex_unlock(&pool->lock);
+
+	for (int i = 0; i < pool->num_workers; i++)
+		pthread_join(pool->workers[i].thread, NULL);
+
+	pthread_cond_destroy(&pool->done);
+	pthread_cond_destroy(&pool->start);
+	pthread_mutex_destroy(&pool->lock);
+	free(pool->workers);
+}
+
+void pool_run(struct pool *pool, pool_fn func, void *ctx,
+	      long long num_items, long long chunk_size)
+{
+	int num = pool->num_workers;
+	long long num_chunks;
+
+	if (chunk_size < 1)
+		chunk_size = 1;
+	if (num_items / chunk_size >= 1LL << 31)
+		chunk_size = num_items / ((1LL << 31) - 1) + 1;
+	num_chunks = (num_items + chunk_size - 1) / chunk_size;
+
+	pthread_mutex_lock(&pool->lock);
+	pool->func = func;
+	pool->ctx = ctx;
+	pool->num_items = num_items;
+	pool->chunk_size = chunk_size;
+	/* Worker i starts with i-th contiguous part of chunks */
+	for (int i = 0; i < num; i++)
+		__atomic_store_n(&pool->workers[i].deque,
+				 DEQUE(num_chunks * i / num,
+				       num_chunks * (i + 1) / num),
+				 __ATOMIC_RELAXED);
+	pool->running = num;
+	pool->generation++;
+	pthread_cond_broadcast(&pool->start);
+	while (pool->running)
+		pthread_cond_wait(&pool->done, &pool->lock);
+	pthread_mutex_unlock(&pool->lock);
+}
@@ -0,0 +1,98 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stdbool.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/types.h>
+
+/* Size of cache line. Deques of workers are kept apart */
+#define POOL_CACHE_LINE 64
+
+/**
+ * typedef pool_fn - function, which processes one chunk of job.
+ * @ctx:	job context, given to pool_run().
+ * @worker:	index of worker, which runs chunk. Use it for per-worker data.
+ * @begin:	first item of chunk.
+ * @end:	item after the last one of chunk.
+ */
+typedef void (*pool_fn)(void *ctx, int worker, long long begin, long long end);
+
+/**
+ * struct pool_worker - worker thread of pool.
+ * @deque:	chunks left to this worker, first | end << 32. Owner takes
+ *		chunks from the front, thieves - from the back.
+ * @pool:	pool this worker belongs to.
+ * @id:		index of worker.
+ * @domain:	locality domain (e.g. NUMA node), 0 by default. Workers steal
+ *		from the same domain first.
+ * @thread:	thread of worker.
+ * @tid:	kernel thread id of worker, e.g. for perf_event_open().
+ * @start_time:	when worker started the last job (CLOCK_MONOTONIC_RAW).
+ * @end_time:	when worker finished the last job.
+ * @chunks:	chunks done in the last job.
+ * @stolen:	chunks stolen from others in the last job.
+ */
+struct pool_worker {
+	_Alignas(POOL_CACHE_LINE) unsigned long long deque;
+	struct pool *pool;
+	int id;
+	int domain;
+	pthread_t thread;
+	pid_t tid;
+	struct timespec start_time, end_time;
+	long long chunks, stolen;
+};
+
+/**
+ * struct pool - persistent pool of worker threads with work stealing.
+ *
+ * Workers are created once and sleep between jobs. Every job is a range of
+ * items, split into chunks. Each worker starts with its own contiguous part
+ * of chunks and, when it is done, steals chunks from others.
+ */
+struct pool {
+	int num_workers;
+	struct pool_worker *workers;
+	pthread_mutex_t lock;
+	pthread_cond_t start, done;
+	unsigned long generation;	/* incremented for every job */
+	int running;			/* workers busy with current job */
+	bool stop;
+	/* Current job */
+	pool_fn func;
+	void *ctx;
+	long long num_items, chunk_size;
+};
+
+/**
+ * pool_create() - start worker threads.
+ * @pool:		pool to initialize.
+ * @num_workers:	number of threads.
+ * @attr:		attributes for threads or NULL.
+ *
+ * Return: 0 or error number of pthread_create() or malloc().
+ */
+int pool_create(struct pool *pool, int num_workers, const pthread_attr_t *attr);
+
+/**
+ * pool_destroy() - stop and join worker threads.
+ */
+void pool_destroy(struct pool *pool);
+
+/**
+ * pool_run() - run job on all workers and wait till it is done.
+ * @pool:	pool.
+ * @func:	function, called for every chunk.
+ * @ctx:	job context, passed to func.
+ * @num_items:	number of items in job, does not have to divide evenly.
+ * @chunk_size:	items in one chunk. Is increased, if there would be more
+ *		than 2^31 chunks.
+ *
+ * Only one thread can run jobs. Timestamps and counters of the job are left
+ * in pool->workers[].
+ */
+void pool_run(struct pool *pool, pool_fn func, void *ctx,
+	      long long num_items, long long chunk_size);
+
+#endif /* POOL_H */
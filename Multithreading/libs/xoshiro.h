@@ -0,0 +1,72 @@
+#ifndef XOSHIRO_H
+#define XOSHIRO_H
+
+#include <stdint.h>
+
+/**
+ * struct xoshiro - state of xoshiro256+ generator (Blackman, Vigna).
+ *
+ * Few shifts and xors per number, no locks and no shared state, so every
+ * thread can have its own generator.
+ */
+struct xoshiro {
+	uint64_t s[4];
+};
+
+/* splitmix64 step. Used to expand one seed into well mixed state */
+static inline uint64_t splitmix64(uint64_t *x)
+{
+	uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+/**
+ * xoshiro_seed() - initialize generator.
+ * @st:		generator.
+ * @seed:	global seed.
+ * @stream:	number of independent stream, e.g. index of chunk.
+ *
+ * Same seed and stream always give the same sequence, no matter which
+ * thread generates it.
+ */
+static inline void xoshiro_seed(struct xoshiro *st, uint64_t seed, uint64_t stream)
+{
+	uint64_t x = seed ^ splitmix64(&stream);
+	for (int i = 0; i < 4; i++)
+		st->s[i] = splitmix64(&x);
+}
+
+static inline uint64_t xoshiro_rotl(uint64_t x, int k)
+{
+	return (x << k) | (x >> (64 - k));
+}
+
+/**
+ * xoshiro_next() - next 64-bit number. Low bits are weaker, use high ones.
+ */
+static inline uint64_t xoshiro_next(struct xoshiro *st)
+{
+	uint64_t *s = st->s;
+	uint64_t res = s[0] + s[3];
+	uint64_t t = s[1] << 17;
+
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = xoshiro_rotl(s[3], 45);
+	return res;
+}
+
+/**
+ * xoshiro_double() - uniform double in [0; 1) with 53 random bits.
+ */
+static inline double xoshiro_double(struct xoshiro *st)
+{
+	return (xoshiro_next(st) >> 11) * 0x1.0p-53;
+}
+
+#endif /* XOSHIRO_H */
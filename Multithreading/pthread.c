@@ -3,12 +3,27 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <limits.h>
+#include <string.h>
+#include <errno.h>
 #include <stdarg.h>
 #include <unistd.h>
 #include <time.h>
 #include <math.h>
 #include <sched.h>
 #include <pthread.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "libs/logsum.h"
+#include "libs/mapreduce.h"
+#include "libs/bench.h"
+#include "libs/perf.h"
+#include "libs/pool.h"
+#include "libs/node.h"
+#include "libs/xoshiro.h"
 
 /* This variable is module-global to be visible inside plog */
 static bool is_verbose = false;
@@ -36,11 +51,131 @@ static inline int plog(const char *fmt, ...)
 #endif
 
 static const char help_str[] = {
-  "[-h] [-v] -t NUM_THREADS -n ARRAY_SIZE\n"
+  "[-h] [-v] [-c] [-p] [-P] [-r mutex|sharded|atomic] [-k KERNEL] [-s CHUNK_SIZE]"
+  " [-m MAP|FILE.so] [-o REDUCE] [-H LO:HI] [-S POLICY] [-a AFFINITY]"
+  " [-b REPS [-w WARMUP] [-T THREADS] [-N SIZES] [-F csv|json]]"
+  " -t NUM_THREADS {-n ARRAY_SIZE | -f FILE [-n ARRAY_SIZE]}\n"
   "Evaluate the time required to do a simple threaded map-reduce operation"
-  "on randomly generated array of doubles"
+  "on randomly generated array of doubles\n"
+  "  -r  how partial results are combined (default: mutex)\n"
+  "      mutex   - add to shared result under mutex\n"
+  "      sharded - own cache line per thread, tree reduce after join\n"
+  "      atomic  - add to shared result with compare-and-swap\n"
+  "  -k  log-sum kernel (default: auto)\n"
+  "      auto    - the fastest of sse2, avx2 and avx512 this CPU supports\n"
+  "      scalar  - libm log() for every element\n"
+  "      sse2, avx2, avx512 - vectorized polynomial log\n"
+  "      frexp   - log of product of mantissas plus sum of exponents\n"
+  "  -m  function applied to every element (default: log)\n"
+  "      log, sqrt, identity, square\n"
+  "      FILE.so - shared object exporting\n"
+  "                void map_block(double *buf, long long num),\n"
+  "                which maps buf in place\n"
+  "  -o  how mapped elements are combined (default: sum)\n"
+  "      sum, min, max\n"
+  "      kahan   - compensated sum\n"
+  "      hist    - histogram of values in [LO; HI) set by -H\n"
+  "  -H  histogram bounds (default: 0:1)\n"
+  "  -c  check accuracy against single-threaded result\n"
+  "  -s  elements in chunk, unit of work stealing (default: 65536)\n"
+  "  -v  print time of every thread\n"
+  "  -P  count cycles, instructions, LLC misses, branch misses and context\n"
+  "      switches of every thread with perf_event_open (not with -b)\n"
+  "  -p  NUMA-aware parallel generation: threads are pinned to CPUs of\n"
+  "      nodes and fill their own chunks with xoshiro256+, so pages are\n"
+  "      placed on node of thread, which processes them\n"
+  "  -f  reduce over raw file of native doubles instead of generated array.\n"
+  "      File is memory-mapped and read ahead, so it can be larger than\n"
+  "      RAM. -n limits number of doubles read\n"
+  "  -S  scheduling policy of threads: other, fifo or rr (default: other).\n"
+  "      Real-time ones get max priority. If it is not permitted, threads\n"
+  "      inherit policy of main thread, which is reported\n"
+  "  -a  pin every thread to its own CPU (default: threads may migrate)\n"
+  "      compact  - hardware threads of core, then next core\n"
+  "      scatter  - next thread on next package, SMT siblings last\n"
+  "      physical - one thread per physical core, SMT siblings unused\n"
+  "      CPU,CPU,... - explicit list, thread i gets i-th CPU\n"
+  "      Threads wrap around, if there are more of them than CPUs\n"
+  "  -b  benchmark: time REPS runs of every configuration and print\n"
+  "      min, median, p95, stddev, throughput, speedup and efficiency\n"
+  "  -w  untimed runs before the timed ones (default: 1)\n"
+  "  -T  thread counts to sweep: comma-separated list or 'all' for\n"
+  "      1..number of CPUs (default: NUM_THREADS)\n"
+  "  -N  array sizes to sweep: comma-separated list (default: ARRAY_SIZE)\n"
+  "  -F  benchmark output format (default: csv)\n"
 };
 
+/* Size of cache line. Data written by different threads is kept apart */
+#define CACHE_LINE 64
+
+/* How partial results of threads are combined into one */
+enum reduce_mode {
+	R_MUTEX = 0,
+	R_SHARDED,
+	R_ATOMIC,
+	R_COUNT
+};
+
+static const char * const _reduce_names[] = {
+	[R_MUTEX] = "mutex",
+	[R_SHARDED] = "sharded",
+	[R_ATOMIC] = "atomic"
+};
+
+/* Scheduling policies, that can be set with -S */
+static const struct {
+	const char *name;
+	int policy;
+} _policies[] = {
+	{"other", SCHED_OTHER},
+	{"fifo", SCHED_FIFO},
+	{"rr", SCHED_RR}
+};
+
+static const char *policy_name(int policy)
+{
+	for (size_t i = 0; i < sizeof _policies / sizeof *_policies; i++)
+		if (_policies[i].policy == policy)
+			return _policies[i].name;
+	return "unknown";
+}
+
+/* Names of -a strategies, explicit list has none */
+static const char * const _order_names[] = {
+	[CO_COMPACT] = "compact",
+	[CO_SCATTER] = "scatter",
+	[CO_PHYSICAL] = "physical"
+};
+
+/**
+ * parse_affinity() - parse -a argument into list of CPUs.
+ * @str:	strategy name or comma-separated list of CPUs.
+ * @cpus:	where to store CPUs.
+ * @max:	size of cpus.
+ *
+ * Return: number of CPUs or -1 if str is malformed or no CPU is allowed.
+ */
+static int parse_affinity(const char *str, int *cpus, int max)
+{
+	int num = 0;
+	char *end;
+
+	for (int order = 0; order < CO_COUNT; order++)
+		if (!strcmp(str, _order_names[order])) {
+			num = node_cpu_order(order, cpus, max);
+			return num ? num : -1;
+		}
+	while (*str && num < max) {
+		long cpu = strtol(str, &end, 10);
+		if (end == str || cpu < 0 || cpu >= CPU_SETSIZE
+		    || (*end && *end != ','))
+			return -1;
+		cpus[num++] = cpu;
+		str = *end ? end + 1 : end;
+	}
+	return num ? num : -1;
+}
+
 static cpu_set_t all_cores(void)
 {
 	cpu_set_t cpuset;
@@ -76,7 +211,11 @@ enum _errors {
 	E_FOPEN,
 	E_FREAD,
 	E_ALLOC,
-	E_CPUSET
+	E_CPUSET,
+	E_KERNEL,
+	E_THREAD,
+	E_FILE,
+	E_MAP
 };
 
 static const char * const _error_msg[] = {
@@ -84,39 +223,332 @@ static const char * const _error_msg[] = {
 	[E_FOPEN] = "Failed to open '/dev/random'",
 	[E_FREAD] = "Failed to read from '/dev/random'",
 	[E_ALLOC] = "Failed to allocate memory",
-	[E_CPUSET] = "Could not link thread to all CPU cores"
+	[E_CPUSET] = "Could not link thread to all CPU cores",
+	[E_KERNEL] = "Log-sum kernel is not supported by CPU",
+	[E_THREAD] = "Failed to create threads",
+	[E_FILE] = "Failed to map input file",
+	[E_MAP] = "Failed to load map_block() from shared object"
 };
 
 
-struct thread_data {
-	struct timespec start_time, end_time;
-	double *arrptr;		/* Points to start of array slice */
-	long long num_items;	/* Elements in slice */
-	double *resptr;		/* Pointer to result(shared) */
+/* Partial result of one thread. Each one starts at its own cache line */
+struct result_slot {
+	_Alignas(CACHE_LINE) struct mr_acc acc;
+};
+
+/* Job, shared by all threads of pool */
+struct job_data {
+	double *array;		/* Whole array, chunks are its slices */
+	long long num_items;	/* Elements in array */
+	bool prefetch;		/* Array is mapped file, read next chunk ahead */
+	const struct mr_op *op;	/* Map and reduce applied to chunks */
+	enum reduce_mode reduce;	/* How to pass partial result */
+	struct mr_acc *resptr;	/* Pointer to result(shared) */
 	pthread_mutex_t *lock;	/* Lock for result */
-	
+	struct result_slot *slots;	/* Own partial result per thread (sharded) */
+};
+
+
+/**
+ * tree_reduce() - pairwise combination of partial results.
+ * @op:		operator, which reduce is used.
+ * @slots:	array of partial results. Is destroyed.
+ * @num:	number of slots.
+ *
+ * Takes log2(num) steps and has smaller rounding error than linear sum.
+ * Return: combined result, stored in first slot.
+ */
+static struct mr_acc *tree_reduce(const struct mr_op *op,
+				  struct result_slot *slots, int num)
+{
+	for (int step = 1; step < num; step *= 2)
+		for (int i = 0; i + step < num; i += 2 * step)
+			mr_combine(op, &slots[i].acc, &slots[i + step].acc);
+	return &slots[0].acc;
+}
+
+
+/* Parallel generation job */
+struct gen_data {
+	double *array;		/* Array to fill */
+	uint64_t seed;		/* Seed from /dev/random */
+	struct pool *pool;	/* To find node of worker */
 };
 
 
-/* This function runs in each thread */
-void *threadfunc(void *args)
+/**
+ * place_workers() - spread workers over NUMA nodes and pin them to CPUs.
+ * @pool:	pool with workers.
+ *
+ * Workers are split into contiguous groups per node, so initial parts of
+ * job of every node are contiguous too. Node becomes stealing domain.
+ * Return: number of nodes.
+ */
+static int place_workers(struct pool *pool)
+{
+	int num_nodes = node_count();
+	int num = pool->num_workers;
+
+	for (int i = 0; i < num; i++) {
+		struct pool_worker *w = &pool->workers[i];
+		int node = (long long)i * num_nodes / num;
+		int first = (node * num + num_nodes - 1) / num_nodes;
+		int cpu = node_nth_cpu(node, i - first);
+		cpu_set_t cpuset;
+
+		w->domain = node;
+		if (cpu < 0)
+			continue;
+		CPU_ZERO(&cpuset);
+		CPU_SET(cpu, &cpuset);
+		if (pthread_setaffinity_np(w->thread, sizeof cpuset, &cpuset))
+			fprintf(stderr, "Could not pin thread %d to CPU %d\n", i, cpu);
+		plog("Thread %d: node %d, CPU %d\n", i, node, cpu);
+	}
+	return num_nodes;
+}
+
+
+/**
+ * pin_workers() - pin every worker to its own CPU.
+ * @pool:	pool with workers.
+ * @cpus:	CPUs, worker i gets cpus[i % num_cpus].
+ * @num_cpus:	number of CPUs.
+ *
+ * Workers don't migrate during run, so timing is reproducible.
+ */
+static void pin_workers(struct pool *pool, const int *cpus, int num_cpus)
+{
+	for (int i = 0; i < pool->num_workers; i++) {
+		int cpu = cpus[i % num_cpus];
+		cpu_set_t cpuset;
+
+		CPU_ZERO(&cpuset);
+		CPU_SET(cpu, &cpuset);
+		if (pthread_setaffinity_np(pool->workers[i].thread,
+					   sizeof cpuset, &cpuset))
+			fprintf(stderr, "Could not pin thread %d to CPU %d\n", i, cpu);
+		plog("Thread %d: CPU %d\n", i, cpu);
+	}
+}
+
+
+/* Fills chunk of array. Every chunk has its own random stream, so values
+ * don't depend on which thread got the chunk */
+static void genfunc(void *ctx, int worker, long long begin, long long end)
+{
+	struct gen_data *data = ctx;
+	struct xoshiro rng;
+
+	node_bind(&data->array[begin], (end - begin) * sizeof *data->array,
+		  data->pool->workers[worker].domain);
+	xoshiro_seed(&rng, data->seed, begin);
+	for (long long i = begin; i < end; i++)
+		data->array[i] = 2. * xoshiro_double(&rng);
+}
+
+
+/**
+ * map_file() - map file of doubles into memory for sequential reading.
+ * @path:	file name.
+ * @len:	where to store length of mapping in bytes.
+ *
+ * Pages are read by kernel on demand and can be dropped under memory
+ * pressure, so file can be larger than RAM. Both page cache and mapping
+ * are told that reading is sequential, so read-ahead is aggressive.
+ * Return: pointer to mapping or NULL.
+ */
+static double *map_file(const char *path, size_t *len)
+{
+	struct stat st;
+	void *addr;
+	int fd = open(path, O_RDONLY);
+
+	if (fd < 0)
+		return NULL;
+	if (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(double)) {
+		close(fd);
+		return NULL;
+	}
+	posix_fadvise(fd, 0, st.st_size, POSIX_FADV_SEQUENTIAL);
+	addr = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);	/* mapping holds reference to file */
+	if (MAP_FAILED == addr)
+		return NULL;
+	madvise(addr, st.st_size, MADV_SEQUENTIAL);
+	*len = st.st_size;
+	return addr;
+}
+
+/* Asks kernel to start reading pages of [from; to) in background */
+static void prefetch_range(double *from, double *to)
+{
+	uintptr_t page = sysconf(_SC_PAGESIZE);
+	uintptr_t start = (uintptr_t)from & ~(page - 1);
+
+	madvise((void *)start, (uintptr_t)to - start, MADV_WILLNEED);
+}
+
+
+/* This function runs in pool threads for every chunk of array */
+static void chunkfunc(void *ctx, int worker, long long begin, long long end)
 {
-	/* Struct is passed via args at pthread_create so its type is known */
-	struct thread_data *data = args;
+	/* Struct is passed via ctx at pool_run so its type is known */
+	struct job_data *data = ctx;
+
+	/* Usually next chunk of this thread follows the current one */
+	if (data->prefetch && end < data->num_items) {
+		long long next_end = 2 * end - begin;
+		if (next_end > data->num_items)
+			next_end = data->num_items;
+		prefetch_range(&data->array[end], &data->array[next_end]);
+	}
 
-	/* We check the time spent in each thread and the global time */
-	clock_gettime(CLOCK_REALTIME, &data->start_time);
+	const struct mr_op *op = data->op;
+	struct mr_acc r;
+
+	switch (data->reduce) {
+	case R_SHARDED:
+		/* nobody else writes to this slot */
+		op->kernel(op, &data->array[begin], end - begin,
+			   &data->slots[worker].acc);
+		break;
+	case R_ATOMIC:
+		mr_acc_init(&r);
+		op->kernel(op, &data->array[begin], end - begin, &r);
+		mr_combine_atomic(op, data->resptr, &r);
+		break;
+	default:
+		mr_acc_init(&r);
+		op->kernel(op, &data->array[begin], end - begin, &r);
+		pthread_mutex_lock(data->lock); /* wait till acquire */
+		/* Now we own a lock */
+		mr_combine(op, data->resptr, &r);	/* manipulate the shared data */
+		pthread_mutex_unlock(data->lock);      /* release lock for the others */
+	}
+}
 
-	double r = 0.;
-	for (int i = 0; i < data->num_items; i++)
-		r += log(data->arrptr[i]);      /* arrptr is a slice of original array */
 
-	clock_gettime(CLOCK_REALTIME, &data->end_time);
-	pthread_mutex_lock(data->lock); /* wait till acquire */
-	/* Now we own a lock */
-	*data->resptr += r;	/* manipulate the shared data */
-	pthread_mutex_unlock(data->lock);      /* release lock for the others */
+/**
+ * run_once() - run whole map-reduce job on pool.
+ * @pool:	pool of workers.
+ * @job:	job, its partial results are reset.
+ * @chunk_size:	elements in chunk.
+ * @result:	where to store pointer to combined result.
+ *
+ * Return: time of run in ms, including combination of partial results.
+ */
+static double run_once(struct pool *pool, struct job_data *job,
+		       long long chunk_size, struct mr_acc **result)
+{
+	mr_acc_init(job->resptr);
+	for (int i = 0; i < pool->num_workers; i++)
+		mr_acc_init(&job->slots[i].acc);
+
+	double start = bench_now();
+	pool_run(pool, &chunkfunc, job, job->num_items, chunk_size);
+	*result = job->resptr;
+	if (R_SHARDED == job->reduce)
+		*result = tree_reduce(job->op, job->slots, pool->num_workers);
+	return bench_now() - start;
+}
+
+
+/**
+ * perf_print() - print counters and derived ratios.
+ * @prefix:	line prefix.
+ * @value:	counter values, -1 if unavailable.
+ */
+static void perf_print(const char *prefix, const long long *value)
+{
+	printf("%s", prefix);
+	for (int i = 0; i < PC_COUNT; i++)
+		if (value[i] >= 0)
+			printf(" %s: %lld", perf_name(i), value[i]);
+		else
+			printf(" %s: n/a", perf_name(i));
+	if (value[PC_CYCLES] > 0 && value[PC_INSTRUCTIONS] >= 0)
+		printf(", IPC: %.2f",
+		       (double)value[PC_INSTRUCTIONS] / value[PC_CYCLES]);
+	printf("\n");
+}
+
+
+/* Benchmark sweep settings */
+struct bench_conf {
+	int reps;		/* Timed runs of every configuration */
+	int warmup;		/* Untimed runs before them */
+	long long threads[BENCH_MAX_LIST];	/* Thread counts, ascending */
+	int num_threads;
+	long long sizes[BENCH_MAX_LIST];	/* Array sizes, ascending */
+	int num_sizes;
+	enum bench_format format;
+	bool numa;		/* Pin workers to nodes, as with -p */
+	const int *cpus;	/* Or pin them to these CPUs, as with -a */
+	int num_cpus;
+	const char * const *labels;	/* Other parameters for output */
+};
 
+
+/**
+ * run_bench() - time job for every thread count and array size.
+ * @conf:	sweep settings.
+ * @pool:	pool, reused for its own thread count.
+ * @attr:	attributes for threads of other pools.
+ * @job:	job, its num_items is changed.
+ * @chunk_size:	elements in chunk.
+ *
+ * Every thread count gets its own pool, which is created once for all sizes.
+ * Speedup is relative to the smallest thread count.
+ * Return: 0 or error number of pool_create().
+ */
+static int run_bench(const struct bench_conf *conf, struct pool *pool,
+		     const pthread_attr_t *attr, struct job_data *job,
+		     long long chunk_size)
+{
+	double samples[conf->reps];
+	double base_median[BENCH_MAX_LIST];
+	struct mr_acc *result;
+	bool first = true;
+
+	bench_begin(stdout, conf->format, conf->labels);
+	for (int t = 0; t < conf->num_threads; t++) {
+		struct pool own, *cur = pool;
+		if (conf->threads[t] != pool->num_workers) {
+			int ret = pool_create(&own, conf->threads[t], attr);
+			if (ret)
+				return ret;
+			cur = &own;
+			if (conf->numa)
+				place_workers(cur);
+			else if (conf->num_cpus)
+				pin_workers(cur, conf->cpus, conf->num_cpus);
+		}
+		for (int n = 0; n < conf->num_sizes; n++) {
+			struct bench_row row = {
+				.threads = conf->threads[t],
+				.size = conf->sizes[n],
+				.elem_size = sizeof *job->array,
+				.base = conf->threads[0],
+				.labels = conf->labels
+			};
+			job->num_items = row.size;
+			for (int i = 0; i < conf->warmup; i++)
+				run_once(cur, job, chunk_size, &result);
+			for (int i = 0; i < conf->reps; i++)
+				samples[i] = run_once(cur, job, chunk_size, &result);
+			bench_stats(samples, conf->reps, &row.stats);
+			if (0 == t)
+				base_median[n] = row.stats.median;
+			row.speedup = base_median[n] / row.stats.median;
+			row.value = mr_value(job->op, result);
+			bench_print(stdout, conf->format, &row, first);
+			first = false;
+		}
+		if (cur != pool)
+			pool_destroy(cur);
+	}
+	bench_end(stdout, conf->format);
 	return 0;
 }
 
@@ -125,6 +557,29 @@ int main(int argc, char *argv[])
 {
 	int num_threads = 0;
 	long long arr_size = 0;
+	long long chunk_size = 65536;
+	enum reduce_mode reduce = R_MUTEX;
+	enum logsum_kernel kernel = LS_AUTO;
+	bool check = false;
+	bool numa = false;
+	bool counters = false;
+	int policy = SCHED_OTHER;
+	int cpus[CPU_SETSIZE];
+	int num_cpus = 0;
+	const char *affinity = NULL;
+	const char *input = NULL;
+	const char *map_path = NULL;
+	struct bench_conf bench = {
+		.reps = 0,
+		.warmup = 1,
+		.format = BF_CSV
+	};
+	struct mr_op op = {
+		.map = MR_LOG,
+		.reduce = MR_SUM,
+		.lo = 0.,
+		.hi = 1.
+	};
 
 	plog("Arguments given:\n");
 	for (int i = 0; i < argc; i++)
@@ -133,8 +588,9 @@ int main(int argc, char *argv[])
 	/* For moar on getopt: http://bit.ly/getopt_rus */
 	opterr = 0; /* No getopt def err out -- we do it manually */
 	int argopt;
-	/* "hvt:n:" means h,v,t,n switches, t & n require argument */
-	while ((argopt = getopt(argc, argv, "hvt:n:")) != -1) {
+	/* "hvcpPt:n:r:k:s:f:m:o:H:b:w:T:N:F:S:a:" means h,v,c,p,P,t,n,r,k,s,f,
+	 * m,o,H,b,w,T,N,F,S,a switches, all but h, v, c, p & P require argument */
+	while ((argopt = getopt(argc, argv, "hvcpPt:n:r:k:s:f:m:o:H:b:w:T:N:F:S:a:")) != -1) {
 		switch(argopt) {
 		case 'h':
 			printf("Usage: %s %s\n", argv[0], help_str);
@@ -142,12 +598,122 @@ int main(int argc, char *argv[])
 		case 'v':
 			is_verbose = true;
 			break;
+		case 'c':
+			check = true;
+			break;
+		case 'p':
+			numa = true;
+			break;
+		case 'P':
+			counters = true;
+			break;
+		case 'f':
+			input = optarg;
+			break;
+		case 'k':
+			kernel = logsum_parse(optarg);
+			if (LS_COUNT == kernel) {
+				fprintf(stderr, "Unknown kernel '%s'\n", optarg);
+				exit(EXIT_FAILURE);
+			}
+			break;
+		case 'm':
+			op.map = mr_parse_map(optarg);
+			if (MR_USER == op.map)
+				map_path = optarg;
+			break;
+		case 'o':
+			op.reduce = mr_parse_reduce(optarg);
+			if (MR_REDUCE_COUNT == op.reduce) {
+				fprintf(stderr, "Unknown reduce '%s'\n", optarg);
+				exit(EXIT_FAILURE);
+			}
+			break;
+		case 'H':
+			if (sscanf(optarg, "%lf:%lf", &op.lo, &op.hi) != 2
+			    || !(op.lo < op.hi)) {
+				fprintf(stderr, "Bad histogram bounds '%s'\n", optarg);
+				exit(EXIT_FAILURE);
+			}
+			break;
+		case 'S':
+			policy = -1;
+			for (size_t i = 0; i < sizeof _policies / sizeof *_policies; i++)
+				if (!strcmp(optarg, _policies[i].name))
+					policy = _policies[i].policy;
+			if (policy < 0) {
+				fprintf(stderr, "Unknown policy '%s'\n", optarg);
+				exit(EXIT_FAILURE);
+			}
+			break;
+		case 'a':
+			affinity = optarg;
+			num_cpus = parse_affinity(optarg, cpus, CPU_SETSIZE);
+			if (num_cpus <= 0) {
+				fprintf(stderr, "Bad affinity '%s'\n", optarg);
+				exit(EXIT_FAILURE);
+			}
+			break;
+		case 'b':
+			bench.reps = atoi(optarg);
+			if (bench.reps <= 0) {
+				fprintf(stderr, "REPS isn't int > 0\n");
+				exit(EXIT_FAILURE);
+			}
+			break;
+		case 'w':
+			bench.warmup = atoi(optarg);
+			break;
+		case 'T':
+			if (!strcmp(optarg, "all")) {
+				int numcores = sysconf(_SC_NPROCESSORS_ONLN);
+				if (numcores > BENCH_MAX_LIST)
+					numcores = BENCH_MAX_LIST;
+				for (int i = 0; i < numcores; i++)
+					bench.threads[i] = i + 1;
+				bench.num_threads = numcores;
+			} else {
+				bench.num_threads = bench_parse_list(optarg,
+					bench.threads, BENCH_MAX_LIST);
+			}
+			if (bench.num_threads <= 0) {
+				fprintf(stderr, "Bad thread list '%s'\n", optarg);
+				exit(EXIT_FAILURE);
+			}
+			break;
+		case 'N':
+			bench.num_sizes = bench_parse_list(optarg, bench.sizes,
+							   BENCH_MAX_LIST);
+			if (bench.num_sizes <= 0) {
+				fprintf(stderr, "Bad size list '%s'\n", optarg);
+				exit(EXIT_FAILURE);
+			}
+			break;
+		case 'F':
+			bench.format = bench_parse_format(optarg);
+			if (BF_COUNT == bench.format) {
+				fprintf(stderr, "Unknown format '%s'\n", optarg);
+				exit(EXIT_FAILURE);
+			}
+			break;
 		case 't':
 			num_threads = atoi(optarg);
 			break;
 		case 'n':
 			arr_size = atoll(optarg);
 			break;
+		case 's':
+			chunk_size = atoll(optarg);
+			break;
+		case 'r':
+			for (reduce = 0; reduce < R_COUNT; reduce++)
+				if (!strcmp(optarg, _reduce_names[reduce]))
+					break;
+			if (R_COUNT == reduce) {
+				fprintf(stderr, "Unknown reduce mode '%s'\n", optarg);
+				exit(EXIT_FAILURE);
+			}
+			break;
 		default:
 			fprintf(stderr, "Unknown option '%s'\n", optarg);
 			exit(EXIT_FAILURE);
@@ -161,20 +727,51 @@ int main(int argc, char *argv[])
 		printf("Usage: %s %s\n", argv[0], help_str);
 		exit(0);
 	}
-	if (num_threads <= 0 || arr_size <= 0) {
-		fprintf(stderr, "NUM_THREADS and ARRAY_SIZE aren't ints > 0\n");
+	/* With input file ARRAY_SIZE is optional */
+	if (NULL != input && 0 == arr_size)
+		arr_size = LLONG_MAX;
+	/* Sweep lists default to single values. Array and pool are made for
+	 * the largest ones */
+	if (bench.reps > 0) {
+		if (0 == bench.num_threads && num_threads > 0)
+			bench.threads[bench.num_threads++] = num_threads;
+		if (0 == bench.num_sizes && arr_size > 0)
+			bench.sizes[bench.num_sizes++] = arr_size;
+		if (bench.num_threads > 0)
+			num_threads = bench.threads[bench.num_threads - 1];
+		if (bench.num_sizes > 0)
+			arr_size = bench.sizes[bench.num_sizes - 1];
+		bench.numa = numa;
+		bench.cpus = cpus;
+		bench.num_cpus = num_cpus;
+	}
+	if (numa && num_cpus) {
+		fprintf(stderr, "-p places threads itself, -a can't be used with it\n");
 		exit(EXIT_FAILURE);
 	}
-	if (arr_size % num_threads) {
-		fprintf(stderr, "NUM_THREADS is not a divisor of ARRAY_SIZE\n");
+	if (num_threads <= 0 || arr_size <= 0 || chunk_size <= 0) {
+		fprintf(stderr, "NUM_THREADS, ARRAY_SIZE and CHUNK_SIZE aren't ints > 0\n");
 		exit(EXIT_FAILURE);
 	}
 
-	pthread_t threads[num_threads];
-	struct thread_data th_dat[num_threads];
-
 	enum _errors errlvl = E_OK;
-	/* Fill array with randoms */
+	kernel = logsum_resolve(kernel);
+	op.logsum = logsum_get(kernel);
+	if (NULL == op.logsum) {
+		errlvl = E_KERNEL;
+		goto exc_kernel;
+	}
+	if (mr_op_init(&op, map_path) < 0) {
+		errlvl = E_MAP;
+		goto exc_kernel;
+	}
+	struct result_slot *slots = aligned_alloc(CACHE_LINE,
+						  num_threads * sizeof *slots);
+	if (NULL == slots) {
+		errlvl = E_ALLOC;
+		goto exc_slots;
+	}
+	/* Get seed for randoms */
 	FILE *fp_rand = fopen("/dev/random", "rb");
 	if (NULL == fp_rand) {
 		errlvl = E_FOPEN;	/* Notice how error handling is done */
@@ -189,80 +786,227 @@ int main(int argc, char *argv[])
 	srand(seed);
 	plog("Random seed set to: 0x%X\n", seed);
 
-	double *array = malloc(arr_size * sizeof *array);
-	for (long long i = 0; i < arr_size; i++)
-		array[i] = (2. / RAND_MAX) * rand();
+	double *array;
+	size_t map_len = 0;
+	if (NULL != input) {
+		array = map_file(input, &map_len);
+		if (NULL == array) {
+			errlvl = E_FILE;
+			goto exc_fread;
+		}
+		if ((size_t)arr_size > map_len / sizeof *array)
+			arr_size = map_len / sizeof *array;
+		/* Sizes beyond the file become its size */
+		for (int i = 0; i < bench.num_sizes; i++)
+			if (bench.sizes[i] > arr_size)
+				bench.sizes[i] = arr_size;
+		plog("Mapped '%s': %lld doubles\n", input, arr_size);
+	} else {
+		array = malloc(arr_size * sizeof *array);
+		if (NULL == array) {
+			errlvl = E_ALLOC;
+			goto exc_fread;
+		}
+	}
 
 	/* Configure thread flags */
 	/* Moar: http://maxim.int.ru/bookshelf/PthreadsProgram/htm/r_37.html */
 	pthread_attr_t thread_attrs;
 	pthread_attr_init(&thread_attrs); /* fill with default attributes */
 	
-	// Set scheduler to FIFO for spawned threads
-	// This allows for less strict implementation requirements
-	pthread_attr_setschedpolicy(&thread_attrs, SCHED_FIFO);
-	// Set maximum priority for main and other threads
-	// As long as on Linux they compete for overall system resources
-	pthread_setschedprio(pthread_self(), sched_get_priority_max(SCHED_FIFO));
-	struct sched_param param;
-	pthread_attr_getschedparam(&thread_attrs, &param);
-	param.sched_priority = sched_get_priority_max(SCHED_FIFO);
+	/* Without explicit scheduling threads inherit policy of creator and
+	 * policy in attributes is silently ignored */
+	pthread_attr_setinheritsched(&thread_attrs, PTHREAD_EXPLICIT_SCHED);
+	pthread_attr_setschedpolicy(&thread_attrs, policy);
+	struct sched_param param = {
+		.sched_priority = sched_get_priority_max(policy)
+	};
 	pthread_attr_setschedparam(&thread_attrs, &param);
-	
-	
-	// See what happens if uncomment this
-	cpu_set_t cpuset = all_cores();
-	int ret = pthread_attr_setaffinity_np(&thread_attrs, sizeof(cpu_set_t), &cpuset);
-	if (ret < 0) {
+
+	/* Unpinned threads may use any core. Pinned ones get own CPU later */
+	int ret = 0;
+	if (0 == num_cpus && !numa) {
+		cpu_set_t cpuset = all_cores();
+		ret = pthread_attr_setaffinity_np(&thread_attrs, sizeof(cpu_set_t), &cpuset);
+	}
+	if (ret) {
 		errlvl = E_CPUSET;
 		goto exc_aff;
 	}
 
 
-	/* Now spawn threads */
+	/* Now spawn threads. They live till the end and sleep between jobs */
+	struct pool pool;
+	ret = pool_create(&pool, num_threads, &thread_attrs);
+	if (EPERM == ret && SCHED_OTHER != policy) {
+		/* Real-time policy needs privileges, go on with inherited one */
+		pthread_attr_setinheritsched(&thread_attrs, PTHREAD_INHERIT_SCHED);
+		ret = pool_create(&pool, num_threads, &thread_attrs);
+	}
+	if (ret) {
+		errlvl = E_THREAD;
+		goto exc_pool;
+	}
+	int got_policy;
+	pthread_getschedparam(pool.workers[0].thread, &got_policy, &param);
+	if (got_policy != policy)
+		fprintf(stderr, "Policy %s was not applied, threads use %s\n",
+			policy_name(policy), policy_name(got_policy));
+	if (num_cpus)
+		pin_workers(&pool, cpus, num_cpus);
+
+	/* Fill array with randoms */
+	int num_nodes = numa ? place_workers(&pool) : 0;
+	double gen_start = bench_now();
+	if (NULL != input) {
+		/* Nothing to generate */
+	} else if (numa) {
+		struct gen_data gen = {
+			.array = array,
+			.seed = seed,
+			.pool = &pool
+		};
+		pool_run(&pool, &genfunc, &gen, arr_size, chunk_size);
+	} else {
+		for (long long i = 0; i < arr_size; i++)
+			array[i] = (2. / RAND_MAX) * rand();
+	}
+	double gen_took = bench_now() - gen_start;
+
 	pthread_mutex_t sharedlock;
 	pthread_mutex_init(&sharedlock, NULL);
 
-	double result = 0.;
-	struct timespec time_now, time_after;
-	clock_gettime(CLOCK_REALTIME, &time_now);
-	for (int i = 0; i < num_threads; i++) {
-		long long slice = arr_size / num_threads;
-		th_dat[i].arrptr = &(array[i * slice]);	/* Points to start of array slice */
-		th_dat[i].num_items = slice;		/* Elements in slice */
-		th_dat[i].resptr = &result;		/* Pointer to result(shared) */
-		th_dat[i].lock = &sharedlock;		/* Lock for result */
-		pthread_create(&threads[i], &thread_attrs,
-                               &threadfunc, &th_dat[i]);
+	struct mr_acc shared, *result;
+	struct job_data job = {
+		.array = array,
+		.num_items = arr_size,
+		.prefetch = NULL != input,
+		.op = &op,
+		.reduce = reduce,
+		.resptr = &shared,
+		.lock = &sharedlock,
+		.slots = slots
+	};
+
+	if (bench.reps > 0) {
+		const char * const labels[] = {
+			"map", map_path ? map_path : mr_map_name(op.map),
+			"reduce", mr_reduce_name(op.reduce),
+			"mode", _reduce_names[reduce],
+			"kernel", logsum_name(kernel),
+			NULL
+		};
+		bench.labels = labels;
+		if (run_bench(&bench, &pool, &thread_attrs, &job, chunk_size))
+			errlvl = E_THREAD;
+		goto exc_bench;
 	}
-	plog("Threads spawned. Performing join\n");
-	for (int i = 0; i < num_threads; i++)
-		pthread_join(threads[i], NULL);
 
-	clock_gettime(CLOCK_REALTIME, &time_after);
+	/* Counters are optional, run goes on without them */
+	struct perf_set *perf = NULL;
+	int num_counters = 0;
+	if (counters)
+		perf = malloc(num_threads * sizeof *perf);
+	for (int i = 0; NULL != perf && i < num_threads; i++)
+		num_counters += perf_open(&perf[i], pool.workers[i].tid);
+	if (counters && 0 == num_counters)
+		fprintf(stderr, "Performance counters are not available\n");
+	for (int i = 0; num_counters && i < num_threads; i++)
+		perf_start(&perf[i]);
 
 	/* Calculate the resulting times */
-	double took_global = timespec_diff(&time_after, &time_now);
+	double took_global = run_once(&pool, &job, chunk_size, &result);
+
+	long long perf_total[PC_COUNT];
+	for (int c = 0; c < PC_COUNT; c++)
+		perf_total[c] = -1;
+	for (int i = 0; num_counters && i < num_threads; i++) {
+		perf_stop(&perf[i]);
+		perf_close(&perf[i]);
+		for (int c = 0; c < PC_COUNT; c++) {
+			if (perf[i].value[c] < 0)
+				continue;
+			if (perf_total[c] < 0)
+				perf_total[c] = 0;
+			perf_total[c] += perf[i].value[c];
+		}
+	}
 	double took_avg = 0.;
 	for (int i = 0; i < num_threads; i++) {
-		took_avg += timespec_diff(&(th_dat[i].end_time), 
-					  &(th_dat[i].start_time));	
+		struct pool_worker *w = &pool.workers[i];
+		double took = timespec_diff(&w->end_time, &w->start_time);
+		took_avg += took;
+		if (is_verbose)
+			printf("Thread %d: %g ms, chunks: %lld, stolen: %lld\n",
+			       i, took, w->chunks, w->stolen);
+		if (is_verbose && num_counters)
+			perf_print("  counters:", perf[i].value);
 	}
 	took_avg /= num_threads;
 
-	printf("Numbers: %lld\nThreads: %d\nValue (result): %g\n"
+	double value = mr_value(&op, result);
+	printf("Numbers: %lld\nThreads: %d\nReduce: %s\nKernel: %s\n"
+	       "Operator: %s/%s\nValue (result): %g\n"
 	       "Average thread time, ms: %g\nCalculation took, ms: %g\n", 
-	       arr_size, num_threads, result, took_avg, took_global);
+	       arr_size, num_threads, _reduce_names[reduce],
+	       logsum_name(kernel), map_path ? map_path : mr_map_name(op.map),
+	       mr_reduce_name(op.reduce), value, took_avg, took_global);
+	if (MR_HIST == op.reduce) {
+		double width = (op.hi - op.lo) / MR_HIST_BINS;
+		printf("Below %g: %lld\n", op.lo, result->hist[0]);
+		for (int i = 1; i <= MR_HIST_BINS; i++)
+			printf("[%g; %g): %lld\n", op.lo + (i - 1) * width,
+			       op.lo + i * width, result->hist[i]);
+		printf("Above %g: %lld\n", op.hi, result->hist[MR_HIST_BINS + 1]);
+	}
+	printf("Policy: %s, priority %d%s\nAffinity: %s\n",
+	       policy_name(got_policy), param.sched_priority,
+	       got_policy == policy ? "" : " (requested one was not applied)",
+	       affinity ? affinity : numa ? "NUMA nodes" : "none");
+	if (num_counters)
+		perf_print("Counters (all threads):", perf_total);
+	free(perf);
+	if (numa)
+		printf("NUMA nodes: %d\n", num_nodes);
+	if (NULL != input)
+		printf("Input file: %s\n", input);
+	else
+		printf("Generation took, ms: %g\n", gen_took);
+	if (check) {
+		/* Reference is libm and one thread, compensated for sums */
+		struct mr_op ref = op;
+		struct mr_acc acc;
+		if (MR_SUM == ref.reduce)
+			ref.reduce = MR_KAHAN;
+		ref.logsum = NULL;
+		mr_op_init(&ref, map_path);
+		mr_acc_init(&acc);
+		ref.kernel(&ref, array, arr_size, &acc);
+		double expected = mr_value(&ref, &acc);
+		mr_op_destroy(&ref);
+		printf("Scalar result: %.17g\nRelative error: %g\n", expected,
+		       expected == value ? 0. : fabs((value - expected) / expected));
+	}
 	
+	exc_bench:
 	pthread_mutex_destroy(&sharedlock);
-	free(array);
+	pool_destroy(&pool);
 
 	/* This stuff should appear in opposite direction */
+	exc_pool:
 	exc_aff:
 		pthread_attr_destroy(&thread_attrs);
+		if (NULL != input)
+			munmap(array, map_len);
+		else
+			free(array);
 	exc_fread:
 		fclose(fp_rand);
 	exc_fopen:
+		free(slots);
+	exc_slots:
+		mr_op_destroy(&op);
+	exc_kernel:
 
 	if (E_OK == errlvl)
 		return 0;
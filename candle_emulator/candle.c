@@ -3,54 +3,212 @@
 #endif
 
 #include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include <avr/sleep.h>
 #include <stdint.h>
 
-static void soft_delay(volatile uint16_t N)
+#include "flame.h"
+
+/*
+ * Every compare output of timers 0, 1 and 2 drives a flame with hardware PWM:
+ * OC0A (PD6), OC0B (PD5), OC1A (PB1), OC1B (PB2), OC2A (PB3), OC2B (PD3).
+ * Every pin of BAM_MASK_x drives one more flame with bit angle modulation from
+ * overflow interrupt of timer 1: bit n of compare value is put out for 2^n
+ * periods of PWM, so 255 periods put out the whole value.
+ */
+#define HW_CHANNELS 6
+
+/*
+ * BAM is opt-in: it needs timers at full speed, so core wakes up 64 times more
+ * often. E.g. -DBAM_MASK_B=0x31 -DBAM_MASK_C=0x3F -DBAM_MASK_D=0x94 gives 12
+ * more flames on PB0, PB4, PB5 (board LED), PC0 - PC5, PD2, PD4 and PD7.
+ */
+#ifndef BAM_MASK_B
+#define BAM_MASK_B 0
+#endif
+#ifndef BAM_MASK_C
+#define BAM_MASK_C 0
+#endif
+#ifndef BAM_MASK_D
+#define BAM_MASK_D 0
+#endif
+
+/* Hardware PWM outputs, crystal and reset can't be BAM pins */
+#if BAM_MASK_B & ((1 << PB1) | (1 << PB2) | (1 << PB3) | (1 << PB6) | (1 << PB7))
+#error "BAM_MASK_B has pin of PWM output or crystal"
+#endif
+#if BAM_MASK_C & ~0x3F
+#error "BAM_MASK_C has pin, which is not PC0 - PC5"
+#endif
+#if BAM_MASK_D & ((1 << PD3) | (1 << PD5) | (1 << PD6))
+#error "BAM_MASK_D has pin of PWM output"
+#endif
+
+#define BITS8(m) (((m) & 1) + ((m) >> 1 & 1) + ((m) >> 2 & 1) + ((m) >> 3 & 1) + \
+                  ((m) >> 4 & 1) + ((m) >> 5 & 1) + ((m) >> 6 & 1) + ((m) >> 7 & 1))
+#define BAM_CHANNELS (BITS8(BAM_MASK_B) + BITS8(BAM_MASK_C) + BITS8(BAM_MASK_D))
+#define CHANNELS (HW_CHANNELS + BAM_CHANNELS)
+
+/*
+ * BAM cycle is 255 overflows, so it needs timer at full speed to be refreshed
+ * at 245 Hz with 16 MHz clock. Without it slower timers wake core up less.
+ */
+#if BAM_CHANNELS
+#define PWM_PRESCALER 1
+#define PWM_CS (1 << CS00)
+#define PWM_CS2 (1 << CS20)
+#else
+#define PWM_PRESCALER 64
+#define PWM_CS ((1 << CS01) | (1 << CS00))
+#define PWM_CS2 (1 << CS22)
+#endif
+
+/* Frames per second, counted in overflows of timer 1 */
+#ifndef FRAME_RATE
+#define FRAME_RATE 10
+#endif
+
+#define FRAME_TICKS (F_CPU / PWM_PRESCALER / 256 / FRAME_RATE)
+#if FRAME_TICKS > 65535
+#error "FRAME_RATE is too low"
+#endif
+/* Filled BAM buffer has to be shown for a whole cycle before the next frame */
+#if FRAME_TICKS < 2 * 255 * (BAM_CHANNELS > 0) || FRAME_TICKS < 1
+#error "FRAME_RATE is too high"
+#endif
+
+static const uint8_t intensity[FLAME_TABLE_SIZE] PROGMEM = LEVEL_TABLE;
+
+/* Generator and compare value of every flame, hardware ones go first */
+static uint16_t seeds[CHANNELS];
+static uint8_t levels[CHANNELS];
+
+enum {BAM_PORT_B, BAM_PORT_C, BAM_PORT_D, BAM_PORTS};
+
+/* Port bits for every bit of compare values, one buffer is shown by ISR */
+static uint8_t bam[2][8][BAM_PORTS];
+static volatile uint8_t bam_shown;
+static volatile uint8_t bam_ready;
+
+static volatile uint8_t frame_due;
+
+void candle(uint8_t ch)
 {
-    volatile uint8_t inner = 0xFF;
-    while (N--)
-        while (inner--);
+    uint8_t level = pgm_read_byte(&intensity[FLAME_INDEX(xorshift16(&seeds[ch]))]);
+    if(level)
+    	levels[ch] = level;
 }
 
-inline uint16_t LKG()
+/* Bit n of BAM channel's value goes to its pin in buf[n] */
+static void bam_fill(uint8_t buf[8][BAM_PORTS])
 {
-	static uint16_t seed = 10;
-    return seed = (7141 * seed + 54773) % 259200;
+    static const uint8_t masks[BAM_PORTS] = {BAM_MASK_B, BAM_MASK_C, BAM_MASK_D};
+    const uint8_t *level = &levels[HW_CHANNELS];
+
+    for(uint8_t port = 0; port < BAM_PORTS; port++)
+    {
+        for(uint8_t n = 0; n < 8; n++)
+            buf[n][port] = 0;
+        for(uint8_t pin = 1; pin; pin <<= 1)
+        {
+            if(!(masks[port] & pin))
+                continue;
+            uint8_t value = *level++;
+            for(uint8_t n = 0; n < 8; n++, value >>= 1)
+                if(value & 1)
+                    buf[n][port] |= pin;
+        }
+    }
 }
 
-void candle()
+static void frame(void)
 {
-    uint16_t gen = LKG();
-    if(gen > 30294)
-    	OCR0A = 255;
-    else if(gen > 24000)
-        OCR0A = 232;
-    else if(gen > 20458)
-        OCR0A = 217;
-    else if(gen > 18492)
-        OCR0A = 200;
-    else if(gen > 16524)
-        OCR0A = 182;
-    else if(gen > 14557)
-        OCR0A = 167;
-    else if(gen > 12590)
-        OCR0A = 150;
+    for(uint8_t ch = 0; ch < CHANNELS; ch++)
+        candle(ch);
+
+    /* Compare registers are double buffered in fast PWM, so no glitches */
+    OCR0A = levels[0];
+    OCR0B = levels[1];
+    OCR1A = levels[2];
+    OCR1B = levels[3];
+    OCR2A = levels[4];
+    OCR2B = levels[5];
+
+    if(BAM_CHANNELS)
+    {
+    	/* ISR changes bam_shown only when buffer is ready */
+        bam_fill(bam[bam_shown ^ 1]);
+        /* Buffer isn't volatile, compiler may move its stores past the flag otherwise */
+        __asm__ __volatile__("" ::: "memory");
+        bam_ready = 1;
+    }
+}
+
+/* Counts frames and puts out the next bit of BAM values, when it's due */
+ISR(TIMER1_OVF_vect)
+{
+    static uint16_t frame_left = FRAME_TICKS;
+    static uint8_t bit = 7, bit_left = 1;
+
+    if(!--frame_left)
+    {
+        frame_left = FRAME_TICKS;
+        frame_due = 1;
+    }
+
+    if(!BAM_CHANNELS || --bit_left)
+        return;
+    bit = (bit + 1) & 7;
+    bit_left = 1 << bit;
+    if(!bit && bam_ready)
+    {
+        bam_shown ^= 1;
+        bam_ready = 0;
+    }
+
+    const uint8_t *out = bam[bam_shown][bit];
+    if(BAM_MASK_B)
+        PORTB = (PORTB & ~BAM_MASK_B) | out[BAM_PORT_B];
+    if(BAM_MASK_C)
+        PORTC = (PORTC & ~BAM_MASK_C) | out[BAM_PORT_C];
+    if(BAM_MASK_D)
+        PORTD = (PORTD & ~BAM_MASK_D) | out[BAM_PORT_D];
 }
 
 int main(void)
 {
-	//Fast PWM on PIN6
-	TCCR0A = (1 << COM0B1) | (1 << WGM00) | (1 << WGM01) | (1 << COM0A1);
-	//No prescaler
-    TCCR0B = (1 << CS00);
-	//OC0A - out
-    DDRD |= 1 << 6; 
+	//Fast PWM on all compare outputs, non-inverting
+	TCCR0A = (1 << COM0A1) | (1 << COM0B1) | (1 << WGM01) | (1 << WGM00);
+    TCCR0B = PWM_CS;
+	//8-bit fast PWM on timer 1, its overflow ticks frames and BAM
+    TCCR1A = (1 << COM1A1) | (1 << COM1B1) | (1 << WGM10);
+    TCCR1B = (1 << WGM12) | PWM_CS;
+    TCCR2A = (1 << COM2A1) | (1 << COM2B1) | (1 << WGM21) | (1 << WGM20);
+    TCCR2B = PWM_CS2;
+    TIMSK1 = 1 << TOIE1;
+	//Outputs
+    DDRB |= (1 << PB1) | (1 << PB2) | (1 << PB3) | BAM_MASK_B;
+    DDRC |= BAM_MASK_C;
+    DDRD |= (1 << PD3) | (1 << PD5) | (1 << PD6) | BAM_MASK_D;
+
+	//About 2^16 steps of generator, 0.1 s at 16 MHz
+    flame_seed(seeds, CHANNELS);
+
+	//Timers are clocked in idle mode, so PWM goes on while core sleeps
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    sei();
 
     while(1) 
     {
-    	candle();
-    	soft_delay(750);
+    	sleep_mode();
+    	//Frame isn't lost, if it's due just before sleep: overflow wakes core up soon
+    	if(frame_due)
+    	{
+    		frame_due = 0;
+    		frame();
+    	}
     }    
 
     return 0;
-} 
\ No newline at end of file
+}
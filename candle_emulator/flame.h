@@ -0,0 +1,63 @@
+/*
+ * Flicker model of a flame, shared by firmware and host library (host/flicker.c):
+ * generator, its seeding and compare values it is mapped to.
+ */
+#ifndef FLAME_H
+#define FLAME_H
+
+#include <stdint.h>
+
+/* Xorshift with triple 7, 9, 8: full period of 2^16 - 1, shifts and xors only */
+#define FLAME_PERIOD 65535u
+
+static inline uint16_t xorshift16(uint16_t *seed)
+{
+    *seed ^= *seed << 7;
+    *seed ^= *seed >> 9;
+    *seed ^= *seed << 8;
+    return *seed;
+}
+
+/*
+ * Compare value of every 16-bit random number, 0 keeps the previous one.
+ * Brightness distribution of the flame is set by these thresholds.
+ */
+#define LEVEL(gen) ((gen) > 30294 ? 255 : (gen) > 24000 ? 232 : \
+                    (gen) > 20458 ? 217 : (gen) > 18492 ? 200 : \
+                    (gen) > 16524 ? 182 : (gen) > 14557 ? 167 : \
+                    (gen) > 12590 ? 150 : 0)
+/*
+ * Table is indexed by high FLAME_INDEX_BITS of the number, low ones of xorshift
+ * are weaker. Entry i stands for 32 numbers i * 32 ... i * 32 + 31, middle one
+ * is taken, so thresholds are rounded to multiples of 32. Share of every level
+ * stays within 1% of the one thresholds give; high byte alone moved it by up
+ * to 9% (182 got 1792 of 65536 numbers instead of 1968).
+ */
+#define FLAME_INDEX_BITS 11
+#define FLAME_TABLE_SIZE (1 << FLAME_INDEX_BITS)
+#define FLAME_INDEX(gen) ((gen) >> (16 - FLAME_INDEX_BITS))
+
+#define LEVEL1(i) LEVEL((i) * 32L + 16)
+#define LEVEL4(i) LEVEL1(i), LEVEL1(i + 1), LEVEL1(i + 2), LEVEL1(i + 3)
+#define LEVEL16(i) LEVEL4(i), LEVEL4(i + 4), LEVEL4(i + 8), LEVEL4(i + 12)
+#define LEVEL64(i) LEVEL16(i), LEVEL16(i + 16), LEVEL16(i + 32), LEVEL16(i + 48)
+#define LEVEL256(i) LEVEL64(i), LEVEL64(i + 64), LEVEL64(i + 128), LEVEL64(i + 192)
+#define LEVEL_TABLE { LEVEL256(0), LEVEL256(256), LEVEL256(512), LEVEL256(768), \
+                      LEVEL256(1024), LEVEL256(1280), LEVEL256(1536), LEVEL256(1792) }
+
+/*
+ * Flames start evenly apart along period of generator, so their sequences
+ * don't overlap: flame n of num starts at step n * (FLAME_PERIOD / num) from 1.
+ */
+static inline void flame_seed(uint16_t *seeds, uint32_t num)
+{
+    uint16_t seed = 1;
+    for(uint32_t n = 0; n < num; n++)
+    {
+        seeds[n] = seed;
+        for(uint16_t step = FLAME_PERIOD / num; step; step--)
+            xorshift16(&seed);
+    }
+}
+
+#endif
@@ -0,0 +1,313 @@
+#include "flicker.h"
+#include "flame.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FLICKER_AVX2 1
+#else
+#define FLICKER_AVX2 0
+#endif
+
+/* Firmware keeps it in flash, it's the same table */
+static const uint8_t _levels[FLAME_TABLE_SIZE] = LEVEL_TABLE;
+
+static inline uint32_t xorshift32(uint32_t *seed)
+{
+	*seed ^= *seed << 13;
+	*seed ^= *seed >> 17;
+	*seed ^= *seed << 5;
+	return *seed;
+}
+
+/* Finalizer of MurmurHash3: neighbouring pixels get unrelated seeds */
+static uint32_t hash32(uint32_t x)
+{
+	x ^= x >> 16;
+	x *= 0x85ebca6bu;
+	x ^= x >> 13;
+	x *= 0xc2b2ae35u;
+	x ^= x >> 16;
+	return x;
+}
+
+/* Same as candle() of firmware for every pixel */
+static void frame_firmware(const struct flicker *fl, uint16_t *seeds,
+			   uint8_t *levels, size_t num)
+{
+	for (size_t i = 0; i < num; i++) {
+		uint8_t level = fl->table[FLAME_INDEX(xorshift16(&seeds[i]))];
+		levels[i] = level ? level : levels[i];
+	}
+}
+
+static void frame_wide(const struct flicker *fl, uint32_t *seeds,
+		       uint8_t *levels, size_t num)
+{
+	for (size_t i = 0; i < num; i++) {
+		uint8_t level = fl->table[xorshift32(&seeds[i]) >> (32 - FLAME_INDEX_BITS)];
+		levels[i] = level ? level : levels[i];
+	}
+}
+
+#if FLICKER_AVX2
+/*
+ * Table lookup for 32 indices, @lo and @hi are their 16 bits in order: shuffles
+ * can't look up 2048 entries, but table is a few runs of equal entries. Every
+ * run is a compare, which counts runs index is past, and their number looks up
+ * value with one shuffle. Indices are below 2^15, signed compare is fine.
+ * Result of 0 keeps previous value, as in firmware.
+ */
+__attribute__((target("avx2")))
+static inline void lookup_avx2(const struct flicker *fl, __m256i lo, __m256i hi, uint8_t *levels)
+{
+	__m256i run_lo = _mm256_setzero_si256(), run_hi = _mm256_setzero_si256();
+
+	for (int r = 1; r < fl->num_runs; r++) {
+		__m256i last = _mm256_set1_epi16(fl->run_start[r] - 1);
+		run_lo = _mm256_sub_epi16(run_lo, _mm256_cmpgt_epi16(lo, last));
+		run_hi = _mm256_sub_epi16(run_hi, _mm256_cmpgt_epi16(hi, last));
+	}
+	/* Packing goes by 128-bit lanes, permutation restores order */
+	__m256i run = _mm256_permute4x64_epi64(_mm256_packus_epi16(run_lo, run_hi), 0xD8);
+	__m256i value = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)fl->run_level));
+	__m256i level = _mm256_shuffle_epi8(value, run);
+	__m256i prev = _mm256_loadu_si256((const __m256i *)levels);
+	__m256i keep = _mm256_cmpeq_epi8(level, _mm256_setzero_si256());
+	_mm256_storeu_si256((__m256i *)levels, _mm256_blendv_epi8(level, prev, keep));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i xorshift16_avx2(__m256i s)
+{
+	s = _mm256_xor_si256(s, _mm256_slli_epi16(s, 7));
+	s = _mm256_xor_si256(s, _mm256_srli_epi16(s, 9));
+	return _mm256_xor_si256(s, _mm256_slli_epi16(s, 8));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i xorshift32_avx2(__m256i s)
+{
+	s = _mm256_xor_si256(s, _mm256_slli_epi32(s, 13));
+	s = _mm256_xor_si256(s, _mm256_srli_epi32(s, 17));
+	return _mm256_xor_si256(s, _mm256_slli_epi32(s, 5));
+}
+
+/* 16 generators per vector, two vectors give 32 indices */
+__attribute__((target("avx2")))
+static void frame_firmware_avx2(const struct flicker *fl, uint16_t *seeds,
+				uint8_t *levels, size_t num)
+{
+	size_t i = 0;
+
+	for (; i + 32 <= num; i += 32) {
+		__m256i *s = (__m256i *)&seeds[i];
+		__m256i a = xorshift16_avx2(_mm256_loadu_si256(s));
+		__m256i b = xorshift16_avx2(_mm256_loadu_si256(s + 1));
+		_mm256_storeu_si256(s, a);
+		_mm256_storeu_si256(s + 1, b);
+		lookup_avx2(fl, _mm256_srli_epi16(a, 16 - FLAME_INDEX_BITS),
+			    _mm256_srli_epi16(b, 16 - FLAME_INDEX_BITS), &levels[i]);
+	}
+	frame_firmware(fl, &seeds[i], &levels[i], num - i);
+}
+
+/* 8 generators per vector, four vectors give 32 indices */
+__attribute__((target("avx2")))
+static void frame_wide_avx2(const struct flicker *fl, uint32_t *seeds,
+			    uint8_t *levels, size_t num)
+{
+	size_t i = 0;
+
+	for (; i + 32 <= num; i += 32) {
+		__m256i *s = (__m256i *)&seeds[i];
+		__m256i v[4];
+		for (int k = 0; k < 4; k++) {
+			v[k] = xorshift32_avx2(_mm256_loadu_si256(s + k));
+			_mm256_storeu_si256(s + k, v[k]);
+			v[k] = _mm256_srli_epi32(v[k], 32 - FLAME_INDEX_BITS);
+		}
+		/* Packing goes by 128-bit lanes, permutation restores order */
+		__m256i lo = _mm256_packus_epi32(v[0], v[1]);
+		__m256i hi = _mm256_packus_epi32(v[2], v[3]);
+		lookup_avx2(fl, _mm256_permute4x64_epi64(lo, 0xD8),
+			    _mm256_permute4x64_epi64(hi, 0xD8), &levels[i]);
+	}
+	frame_wide(fl, &seeds[i], &levels[i], num - i);
+}
+#endif /* FLICKER_AVX2 */
+
+bool flicker_simd_supported(void)
+{
+#if FLICKER_AVX2
+	return __builtin_cpu_supports("avx2");
+#else
+	return false;
+#endif
+}
+
+/* Computes rows of thread, part of frame */
+static void frame_part(struct flicker *fl, int part)
+{
+	size_t first = fl->height * part / fl->num_threads * fl->width;
+	size_t end = fl->height * (part + 1) / fl->num_threads * fl->width;
+	uint8_t *levels = &fl->levels[first];
+
+	if (FLICKER_FIRMWARE == fl->gen) {
+		uint16_t *seeds = (uint16_t *)fl->seeds + first;
+#if FLICKER_AVX2
+		if (fl->simd) {
+			frame_firmware_avx2(fl, seeds, levels, end - first);
+			return;
+		}
+#endif
+		frame_firmware(fl, seeds, levels, end - first);
+	} else {
+		uint32_t *seeds = (uint32_t *)fl->seeds + first;
+#if FLICKER_AVX2
+		if (fl->simd) {
+			frame_wide_avx2(fl, seeds, levels, end - first);
+			return;
+		}
+#endif
+		frame_wide(fl, seeds, levels, end - first);
+	}
+}
+
+static void *thread_main(void *arg)
+{
+	struct flicker_thread *ft = arg;
+	struct flicker *fl = ft->fl;
+	unsigned long seen = 0;
+
+	pthread_mutex_lock(&fl->lock);
+	for (;;) {
+		while (fl->generation == seen && !fl->stop)
+			pthread_cond_wait(&fl->start, &fl->lock);
+		if (fl->stop)
+			break;
+		seen = fl->generation;
+		pthread_mutex_unlock(&fl->lock);
+
+		frame_part(fl, ft->part);
+
+		pthread_mutex_lock(&fl->lock);
+		if (0 == --fl->running)
+			pthread_cond_signal(&fl->done);
+	}
+	pthread_mutex_unlock(&fl->lock);
+	return NULL;
+}
+
+/* Stops threads before @num */
+static void stop_threads(struct flicker *fl, int num)
+{
+	pthread_mutex_lock(&fl->lock);
+	fl->stop = true;
+	pthread_cond_broadcast(&fl->start);
+	pthread_mutex_unlock(&fl->lock);
+	for (int t = 1; t < num; t++)
+		pthread_join(fl->threads[t].thread, NULL);
+	pthread_mutex_destroy(&fl->lock);
+	pthread_cond_destroy(&fl->start);
+	pthread_cond_destroy(&fl->done);
+}
+
+/* Runs of equal entries of table for lookup_avx2() */
+static bool find_runs(struct flicker *fl)
+{
+	fl->num_runs = 0;
+	for (int i = 0; i < FLAME_TABLE_SIZE; i++) {
+		if (i > 0 && fl->table[i] == fl->table[i - 1])
+			continue;
+		if (FLICKER_MAX_RUNS == fl->num_runs)
+			return false;
+		fl->run_start[fl->num_runs] = i;
+		fl->run_level[fl->num_runs++] = fl->table[i];
+	}
+	return true;
+}
+
+int flicker_init(struct flicker *fl, size_t width, size_t height,
+		 enum flicker_gen gen, int num_threads, bool simd)
+{
+	size_t num = width * height;
+	int ret;
+
+	memset(fl, 0, sizeof *fl);
+	if (0 == num || num_threads < 1
+	    || (FLICKER_FIRMWARE == gen && num > FLAME_PERIOD))
+		return EINVAL;
+	fl->width = width;
+	fl->height = height;
+	fl->gen = gen;
+	fl->num_threads = (size_t)num_threads < height ? num_threads : (int)height;
+	memcpy(fl->table, _levels, sizeof fl->table);
+	fl->simd = simd && flicker_simd_supported() && find_runs(fl);
+
+	fl->levels = calloc(num, 1);
+	fl->seeds = malloc(num * (FLICKER_FIRMWARE == gen ? 2 : 4));
+	fl->threads = malloc(fl->num_threads * sizeof *fl->threads);
+	if (NULL == fl->levels || NULL == fl->seeds || NULL == fl->threads) {
+		ret = ENOMEM;
+		goto free_mem;
+	}
+	if (FLICKER_FIRMWARE == gen) {
+		flame_seed(fl->seeds, num);
+	} else {
+		uint32_t *seeds = fl->seeds;
+		for (size_t i = 0; i < num; i++)
+			seeds[i] = hash32(i + 1) ? hash32(i + 1) : 1;
+	}
+
+	pthread_mutex_init(&fl->lock, NULL);
+	pthread_cond_init(&fl->start, NULL);
+	pthread_cond_init(&fl->done, NULL);
+	/* Part 0 is done by caller of flicker_frame() */
+	for (int t = 1; t < fl->num_threads; t++) {
+		fl->threads[t].fl = fl;
+		fl->threads[t].part = t;
+		ret = pthread_create(&fl->threads[t].thread, NULL, thread_main,
+				     &fl->threads[t]);
+		if (ret) {
+			stop_threads(fl, t);
+			goto free_mem;
+		}
+	}
+	return 0;
+
+free_mem:
+	free(fl->threads);
+	free(fl->seeds);
+	free(fl->levels);
+	return ret;
+}
+
+void flicker_frame(struct flicker *fl)
+{
+	if (fl->num_threads > 1) {
+		pthread_mutex_lock(&fl->lock);
+		fl->generation++;
+		fl->running = fl->num_threads - 1;
+		pthread_cond_broadcast(&fl->start);
+		pthread_mutex_unlock(&fl->lock);
+	}
+
+	frame_part(fl, 0);
+
+	pthread_mutex_lock(&fl->lock);
+	while (fl->running)
+		pthread_cond_wait(&fl->done, &fl->lock);
+	pthread_mutex_unlock(&fl->lock);
+}
+
+void flicker_destroy(struct flicker *fl)
+{
+	stop_threads(fl, fl->num_threads);
+	free(fl->threads);
+	free(fl->seeds);
+	free(fl->levels);
+}
@@ -0,0 +1,112 @@
+#ifndef FLICKER_H
+#define FLICKER_H
+
+#include "flame.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+
+/* Most runs of equal entries in table of compare values, SIMD lookup shuffles their values */
+#define FLICKER_MAX_RUNS 16
+
+/**
+ * enum flicker_gen - generator of every pixel.
+ * @FLICKER_WIDE:	xorshift32, seeds are hashes of pixel index. Period is
+ *			2^32 - 1 and any number of pixels is fine.
+ * @FLICKER_FIRMWARE:	xorshift16 of firmware with its seeding: pixel n gets
+ *			the same sequence as flame n of firmware with as many
+ *			flames. Up to FLAME_PERIOD pixels.
+ */
+enum flicker_gen {
+	FLICKER_WIDE,
+	FLICKER_FIRMWARE
+};
+
+/**
+ * struct flicker_thread - thread, which computes part of frame.
+ * @fl:		generator it belongs to.
+ * @part:	index of its rows.
+ * @thread:	thread itself.
+ */
+struct flicker_thread {
+	struct flicker *fl;
+	int part;
+	pthread_t thread;
+};
+
+/**
+ * struct flicker - generator of frames for a wall of flames.
+ * @width:	pixels in row.
+ * @height:	rows.
+ * @levels:	frame, row after row: compare value (brightness) of every pixel.
+ * @gen:	generator.
+ * @simd:	AVX2 is used.
+ * @seeds:	state of generator of every pixel, uint16_t or uint32_t.
+ * @table:	compare value of high FLAME_INDEX_BITS of random number, 0 keeps
+ *		previous.
+ * @run_start:	first entry of every run of equal entries of @table.
+ * @run_level:	and their value.
+ * @num_runs:	number of runs.
+ * @num_threads:	threads, which compute frame, the caller's one too.
+ * @threads:	other ones, @threads[0] is not used.
+ *
+ * Every pixel flickers as the flame of firmware: every frame its generator
+ * gives a random number, which is mapped to compare value by the same table.
+ * Rows are split evenly between threads, every thread computes its own part
+ * of frame.
+ */
+struct flicker {
+	size_t width, height;
+	uint8_t *levels;
+	enum flicker_gen gen;
+	bool simd;
+	void *seeds;
+	uint8_t table[FLAME_TABLE_SIZE];
+	uint16_t run_start[FLICKER_MAX_RUNS];
+	uint8_t run_level[FLICKER_MAX_RUNS];
+	int num_runs;
+	int num_threads;
+	struct flicker_thread *threads;
+	pthread_mutex_t lock;
+	pthread_cond_t start, done;
+	unsigned long generation;	/* incremented for every frame */
+	int running;			/* threads busy with current frame */
+	bool stop;
+};
+
+/**
+ * flicker_simd_supported() - whether CPU has AVX2 and library is built for it.
+ */
+bool flicker_simd_supported(void);
+
+/**
+ * flicker_init() - allocate frame and seed generators, start threads.
+ * @fl:		generator to initialize.
+ * @width:	pixels in row.
+ * @height:	rows.
+ * @gen:	generator of pixels.
+ * @num_threads:	threads to compute frame with, caller's one included.
+ *			Is limited by @height.
+ * @simd:	use AVX2, if CPU has it. Frames are the same either way.
+ *
+ * All pixels start at 0, as flames of firmware do.
+ *
+ * Return: 0, EINVAL for empty frame, too many pixels for FLICKER_FIRMWARE
+ * or @num_threads < 1, ENOMEM or error number of pthread_create().
+ */
+int flicker_init(struct flicker *fl, size_t width, size_t height,
+		 enum flicker_gen gen, int num_threads, bool simd);
+
+/**
+ * flicker_frame() - compute the next frame in @fl->levels.
+ */
+void flicker_frame(struct flicker *fl);
+
+/**
+ * flicker_destroy() - stop threads and free memory.
+ */
+void flicker_destroy(struct flicker *fl);
+
+#endif /* FLICKER_H */
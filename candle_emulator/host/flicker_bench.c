@@ -0,0 +1,195 @@
+/*
+ * Benchmark of host flicker library: frames per second for a wall of flames.
+ * It also checks, that AVX2 and scalar code give the same frames, that
+ * firmware generator gives the same sequences as flames of firmware, and
+ * that distribution of brightness is the one of firmware table.
+ */
+#include "flicker.h"
+#include "flame.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+static const char help_str[] = {
+	"[-h] [-W WIDTH] [-H HEIGHT] [-t THREADS] [-f FRAMES] [-r RATE] [-x] [-s]\n"
+	"Compute FRAMES frames (default: 1000) of WIDTH x HEIGHT pixels (default:\n"
+	"400 x 250) with THREADS threads (default: 1), report frames per second\n"
+	"against RATE (default: 120)\n"
+	"  -x  firmware generator, bit-exact with candle.c, up to 65535 pixels\n"
+	"  -s  scalar code, no AVX2\n"
+};
+
+/* Frames of checks, generators are compared with each other every frame */
+#define CHECK_FRAMES 200
+
+static double now_ms(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+	return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+/* Same frames with and without AVX2, both from scratch */
+static int check_simd(size_t width, size_t height, enum flicker_gen gen)
+{
+	struct flicker simd, scalar;
+	int ret = 0;
+
+	if (flicker_init(&simd, width, height, gen, 1, true)
+	    || flicker_init(&scalar, width, height, gen, 1, false)) {
+		fprintf(stderr, "Failed to initialize generator\n");
+		exit(EXIT_FAILURE);
+	}
+	for (int f = 0; f < CHECK_FRAMES && 0 == ret; f++) {
+		flicker_frame(&simd);
+		flicker_frame(&scalar);
+		if (memcmp(simd.levels, scalar.levels, width * height)) {
+			fprintf(stderr, "Frame %d: AVX2 differs from scalar code\n", f);
+			ret = -1;
+		}
+	}
+	flicker_destroy(&simd);
+	flicker_destroy(&scalar);
+	return ret;
+}
+
+/* Flames of firmware, its code is in flame.h: candle() for every flame */
+static int check_firmware(const struct flicker *fl, uint16_t *seeds,
+			  uint8_t *levels, int frame)
+{
+	static const uint8_t table[FLAME_TABLE_SIZE] = LEVEL_TABLE;
+	size_t num = fl->width * fl->height;
+
+	for (size_t ch = 0; ch < num; ch++) {
+		uint8_t level = table[FLAME_INDEX(xorshift16(&seeds[ch]))];
+		if (level)
+			levels[ch] = level;
+	}
+	if (memcmp(levels, fl->levels, num)) {
+		fprintf(stderr, "Frame %d: differs from firmware\n", frame);
+		return -1;
+	}
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	size_t width = 400, height = 250;
+	int threads = 1, frames = 1000, rate = 120;
+	enum flicker_gen gen = FLICKER_WIDE;
+	bool simd = true;
+	int argopt, ret;
+
+	while ((argopt = getopt(argc, argv, "hW:H:t:f:r:xs")) != -1) {
+		switch (argopt) {
+		case 'W':
+			width = atol(optarg);
+			break;
+		case 'H':
+			height = atol(optarg);
+			break;
+		case 't':
+			threads = atoi(optarg);
+			break;
+		case 'f':
+			frames = atoi(optarg);
+			break;
+		case 'r':
+			rate = atoi(optarg);
+			break;
+		case 'x':
+			gen = FLICKER_FIRMWARE;
+			break;
+		case 's':
+			simd = false;
+			break;
+		case 'h':
+		default:
+			printf("Usage: %s %s", argv[0], help_str);
+			exit('h' == argopt ? 0 : EXIT_FAILURE);
+		}
+	}
+	if (frames < 1 || rate < 1) {
+		fprintf(stderr, "FRAMES and RATE have to be > 0\n");
+		exit(EXIT_FAILURE);
+	}
+
+	struct flicker fl;
+	size_t num = width * height;
+	if ((ret = flicker_init(&fl, width, height, gen, threads, simd))) {
+		fprintf(stderr, "Failed to initialize generator: %s\n", strerror(ret));
+		if (EINVAL == ret && FLICKER_FIRMWARE == gen && num > FLAME_PERIOD)
+			fprintf(stderr, "Firmware generator takes up to %u pixels\n",
+				FLAME_PERIOD);
+		exit(EXIT_FAILURE);
+	}
+	printf("Pixels: %zu x %zu, threads: %d, generator: %s, code: %s\n",
+	       width, height, fl.num_threads,
+	       FLICKER_FIRMWARE == gen ? "firmware" : "wide",
+	       fl.simd ? "AVX2" : "scalar");
+
+	if (flicker_simd_supported() && check_simd(width, height, gen))
+		exit(EXIT_FAILURE);
+
+	uint16_t *fw_seeds = NULL;
+	uint8_t *fw_levels = NULL;
+	if (FLICKER_FIRMWARE == gen) {
+		fw_seeds = malloc(num * sizeof *fw_seeds);
+		fw_levels = calloc(num, 1);
+		if (NULL == fw_seeds || NULL == fw_levels) {
+			fprintf(stderr, "Failed to allocate memory\n");
+			exit(EXIT_FAILURE);
+		}
+		flame_seed(fw_seeds, num);
+	}
+
+	long hist[256] = {0};
+	double start = now_ms();
+	for (int f = 0; f < frames; f++) {
+		flicker_frame(&fl);
+		/* Checks are out of timing */
+		if (f < CHECK_FRAMES) {
+			double pause = now_ms();
+			if (fw_seeds && check_firmware(&fl, fw_seeds, fw_levels, f))
+				exit(EXIT_FAILURE);
+			for (size_t i = 0; i < num; i++)
+				hist[fl.levels[i]]++;
+			start += now_ms() - pause;
+		}
+	}
+	double ms = now_ms() - start;
+
+	double fps = frames * 1e3 / ms;
+	printf("Frames: %d in %.1f ms, %.1f frames/s (%.1fx of %d), "
+	       "%.2f ns per pixel\n",
+	       frames, ms, fps, fps / rate, rate, ms * 1e6 / frames / num);
+	if (flicker_simd_supported())
+		printf("AVX2 and scalar code: same frames\n");
+	if (fw_seeds)
+		printf("Firmware flames: same sequences\n");
+
+	/* Held value is drawn from table too, so 0 entries just drop out */
+	int table_num[256] = {0}, drawn = 0;
+	long counted = 0;
+	for (int i = 0; i < FLAME_TABLE_SIZE; i++)
+		if (fl.table[i]) {
+			table_num[fl.table[i]]++;
+			drawn++;
+		}
+	for (int v = 1; v < 256; v++)
+		counted += hist[v];
+	printf("Distribution (compare value, share of pixels, of table):\n");
+	for (int v = 1; v < 256; v++)
+		if (table_num[v] || hist[v])
+			printf("%3d  %6.2f%%  %6.2f%%\n", v, hist[v] * 100. / counted,
+			       table_num[v] * 100. / drawn);
+
+	free(fw_levels);
+	free(fw_seeds);
+	flicker_destroy(&fl);
+	return 0;
+}
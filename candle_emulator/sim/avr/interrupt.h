@@ -0,0 +1,18 @@
+/*
+ * Host shim of avr/interrupt.h. Handler is a plain function named after its
+ * vector, harness calls it, when interrupt is due and enabled.
+ */
+#ifndef SIM_AVR_INTERRUPT_H
+#define SIM_AVR_INTERRUPT_H
+
+#include <stdint.h>
+
+/* I bit of SREG */
+extern volatile uint8_t sim_sreg_i;
+
+#define ISR(vector) void vector(void); void vector(void)
+
+#define sei() (sim_sreg_i = 1)
+#define cli() (sim_sreg_i = 0)
+
+#endif
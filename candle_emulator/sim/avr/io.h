@@ -0,0 +1,154 @@
+/*
+ * Host shim for <avr/io.h>. Only registers, which firmware uses, are here.
+ * Every register is an element of sim_regs[], wide enough for 16-bit ones of
+ * timer 1. Access through register macro marks it touched, so harness can log
+ * writes with their timestamps.
+ */
+#ifndef SIM_AVR_IO_H
+#define SIM_AVR_IO_H
+
+#include <stdint.h>
+
+enum sim_reg {
+	SIM_DDRB = 0,
+	SIM_PORTB,
+	SIM_DDRC,
+	SIM_PORTC,
+	SIM_DDRD,
+	SIM_PORTD,
+	SIM_TCCR0A,
+	SIM_TCCR0B,
+	SIM_OCR0A,
+	SIM_OCR0B,
+	SIM_TIMSK0,
+	SIM_TCCR1A,
+	SIM_TCCR1B,
+	SIM_OCR1A,
+	SIM_OCR1B,
+	SIM_TIMSK1,
+	SIM_TCCR2A,
+	SIM_TCCR2B,
+	SIM_OCR2A,
+	SIM_OCR2B,
+	SIM_SMCR,
+	SIM_REG_COUNT
+};
+
+extern volatile uint16_t sim_regs[SIM_REG_COUNT];
+extern volatile uint8_t sim_touched[SIM_REG_COUNT];
+
+static inline volatile uint16_t *sim_io(enum sim_reg reg)
+{
+	sim_touched[reg] = 1;
+	return &sim_regs[reg];
+}
+
+#define _BV(bit)	(1 << (bit))
+
+#define DDRB	(*sim_io(SIM_DDRB))
+#define PORTB	(*sim_io(SIM_PORTB))
+#define DDRC	(*sim_io(SIM_DDRC))
+#define PORTC	(*sim_io(SIM_PORTC))
+#define DDRD	(*sim_io(SIM_DDRD))
+#define PORTD	(*sim_io(SIM_PORTD))
+#define TCCR0A	(*sim_io(SIM_TCCR0A))
+#define TCCR0B	(*sim_io(SIM_TCCR0B))
+#define OCR0A	(*sim_io(SIM_OCR0A))
+#define OCR0B	(*sim_io(SIM_OCR0B))
+#define TIMSK0	(*sim_io(SIM_TIMSK0))
+#define TCCR1A	(*sim_io(SIM_TCCR1A))
+#define TCCR1B	(*sim_io(SIM_TCCR1B))
+#define OCR1A	(*sim_io(SIM_OCR1A))
+#define OCR1B	(*sim_io(SIM_OCR1B))
+#define TIMSK1	(*sim_io(SIM_TIMSK1))
+#define TCCR2A	(*sim_io(SIM_TCCR2A))
+#define TCCR2B	(*sim_io(SIM_TCCR2B))
+#define OCR2A	(*sim_io(SIM_OCR2A))
+#define OCR2B	(*sim_io(SIM_OCR2B))
+#define SMCR	(*sim_io(SIM_SMCR))
+
+/* Port pins */
+#define PB0	0
+#define PB1	1
+#define PB2	2
+#define PB3	3
+#define PB4	4
+#define PB5	5
+#define PB6	6
+#define PB7	7
+#define PC0	0
+#define PC1	1
+#define PC2	2
+#define PC3	3
+#define PC4	4
+#define PC5	5
+#define PC6	6
+#define PD0	0
+#define PD1	1
+#define PD2	2
+#define PD3	3
+#define PD4	4
+#define PD5	5
+#define PD6	6
+#define PD7	7
+
+/* TCCR0A */
+#define WGM00	0
+#define WGM01	1
+#define COM0B0	4
+#define COM0B1	5
+#define COM0A0	6
+#define COM0A1	7
+
+/* TCCR0B */
+#define CS00	0
+#define CS01	1
+#define CS02	2
+#define WGM02	3
+
+/* TIMSK0 */
+#define TOIE0	0
+#define OCIE0A	1
+#define OCIE0B	2
+
+/* TCCR1A */
+#define WGM10	0
+#define WGM11	1
+#define COM1B0	4
+#define COM1B1	5
+#define COM1A0	6
+#define COM1A1	7
+
+/* TCCR1B */
+#define CS10	0
+#define CS11	1
+#define CS12	2
+#define WGM12	3
+#define WGM13	4
+
+/* TIMSK1 */
+#define TOIE1	0
+#define OCIE1A	1
+#define OCIE1B	2
+
+/* TCCR2A */
+#define WGM20	0
+#define WGM21	1
+#define COM2B0	4
+#define COM2B1	5
+#define COM2A0	6
+#define COM2A1	7
+
+/* TCCR2B */
+#define CS20	0
+#define CS21	1
+#define CS22	2
+#define WGM22	3
+
+/* SMCR */
+#define SE	0
+#define SM0	1
+#define SM1	2
+#define SM2	3
+
+#endif /* SIM_AVR_IO_H */
@@ -0,0 +1,14 @@
+/*
+ * Host shim of avr/pgmspace.h: there's one address space, so flash data is
+ * plain const data and is read directly.
+ */
+#ifndef SIM_AVR_PGMSPACE_H
+#define SIM_AVR_PGMSPACE_H
+
+#include <stdint.h>
+
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+
+#endif
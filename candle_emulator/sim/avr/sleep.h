@@ -0,0 +1,32 @@
+/*
+ * Host shim of avr/sleep.h. Sleep itself is sim_sleep() of harness: it
+ * advances AVR time to the next wake-up and runs its interrupt handler.
+ */
+#ifndef SIM_AVR_SLEEP_H
+#define SIM_AVR_SLEEP_H
+
+#include <avr/io.h>
+
+#define SLEEP_MODE_IDLE		0
+#define SLEEP_MODE_ADC		_BV(SM0)
+#define SLEEP_MODE_PWR_DOWN	_BV(SM1)
+#define SLEEP_MODE_PWR_SAVE	(_BV(SM0) | _BV(SM1))
+#define SLEEP_MODE_STANDBY	(_BV(SM1) | _BV(SM2))
+#define SLEEP_MODE_EXT_STANDBY	(_BV(SM0) | _BV(SM1) | _BV(SM2))
+
+void sim_sleep(void);
+
+#define set_sleep_mode(mode) \
+	(SMCR = (SMCR & ~(_BV(SM0) | _BV(SM1) | _BV(SM2))) | (mode))
+/* Are done around every sleep, so they bypass logging of writes */
+#define sleep_enable()	(sim_regs[SIM_SMCR] |= _BV(SE))
+#define sleep_disable()	(sim_regs[SIM_SMCR] &= ~_BV(SE))
+#define sleep_cpu()	sim_sleep()
+#define sleep_mode()			\
+	do {				\
+		sleep_enable();		\
+		sleep_cpu();		\
+		sleep_disable();	\
+	} while (0)
+
+#endif
@@ -0,0 +1,471 @@
+/*
+ * Host simulation of candle firmware. candle.c is included as is with main()
+ * renamed, so its static functions are called and timed directly, and its
+ * registers are elements of shim from sim/avr/io.h.
+ * Firmware main() runs till its sleep, then sim_sleep() advances AVR time to
+ * the next overflow of timer 1 and calls the interrupt handler. So ticks and
+ * frames are timed in AVR cycles from timer registers, while code is timed in
+ * cycles of host CPU. These are good for comparing versions of firmware code
+ * and for regression tests of its output, not as AVR timing.
+ */
+#define main firmware_main
+#include "../candle.c"
+#undef main
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <time.h>
+#include <setjmp.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define sim_cycles() __rdtsc()
+#else
+/* Nanoseconds, where there's no cycle counter */
+static inline uint64_t sim_cycles(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+#endif
+
+volatile uint16_t sim_regs[SIM_REG_COUNT];
+volatile uint8_t sim_touched[SIM_REG_COUNT];
+volatile uint8_t sim_sreg_i;
+
+static const char * const _reg_names[] = {
+	[SIM_DDRB] = "DDRB",
+	[SIM_PORTB] = "PORTB",
+	[SIM_DDRC] = "DDRC",
+	[SIM_PORTC] = "PORTC",
+	[SIM_DDRD] = "DDRD",
+	[SIM_PORTD] = "PORTD",
+	[SIM_TCCR0A] = "TCCR0A",
+	[SIM_TCCR0B] = "TCCR0B",
+	[SIM_OCR0A] = "OCR0A",
+	[SIM_OCR0B] = "OCR0B",
+	[SIM_TIMSK0] = "TIMSK0",
+	[SIM_TCCR1A] = "TCCR1A",
+	[SIM_TCCR1B] = "TCCR1B",
+	[SIM_OCR1A] = "OCR1A",
+	[SIM_OCR1B] = "OCR1B",
+	[SIM_TIMSK1] = "TIMSK1",
+	[SIM_TCCR2A] = "TCCR2A",
+	[SIM_TCCR2B] = "TCCR2B",
+	[SIM_OCR2A] = "OCR2A",
+	[SIM_OCR2B] = "OCR2B",
+	[SIM_SMCR] = "SMCR"
+};
+
+/* Compare registers of hardware channels in order of levels[] */
+static const enum sim_reg _hw_regs[HW_CHANNELS] = {
+	SIM_OCR0A, SIM_OCR0B, SIM_OCR1A, SIM_OCR1B, SIM_OCR2A, SIM_OCR2B
+};
+
+static const char * const _sleep_names[] = {
+	"idle", "ADC noise reduction", "power-down", "power-save",
+	"reserved", "reserved", "standby", "extended standby"
+};
+
+/* Clock select of timer 1 to its prescaler, 0 is stopped or external clock */
+static const unsigned _t1_prescalers[] = {0, 1, 8, 64, 256, 1024, 0, 0};
+
+/* Waveform generation mode of timer 1 to its TOP, 0 is not supported */
+static const unsigned _t1_tops[16] = {
+	[0] = 0xFFFF, [5] = 0xFF, [6] = 0x1FF, [7] = 0x3FF
+};
+
+static const char help_str[] = {
+	"[-h] [-n FRAMES] [-l LOGFILE] [-c CYCLES] [-f CYCLES]\n"
+	"Run firmware for FRAMES frames (default: 2000) on host, report timing\n"
+	"of ticks and frames, output of BAM pins, correlation of channels and\n"
+	"histogram of PWM compare values\n"
+	"  -l  write every register write as 'AVR cycle,register,value' CSV\n"
+	"  -c  AVR cycles per wake-up: wake-up, interrupt entry, handler and return,\n"
+	"      e.g. counted in avr-objdump -d candle.elf or measured on a pin\n"
+	"  -f  AVR cycles of main() per frame. With -c share of time awake is\n"
+	"      reported, host cycles can't give it\n"
+};
+
+/* Fewer frames don't give meaningful percentiles */
+#define MIN_FRAMES 100
+/* Host cycles of interrupt handler are counted in bins, the last is "more" */
+#define ISR_BINS 4096
+
+/* State of simulation shared with sim_sleep() */
+static struct {
+	long frames;		/* to simulate */
+	long done;		/* frames done */
+	long ticks;		/* wake-ups by overflow */
+	uint64_t avr_time;	/* AVR cycles since reset */
+	uint64_t period;	/* AVR cycles between ticks */
+	long isr_cycles;	/* AVR cycles per wake-up, stated with -c */
+	long frame_cycles;	/* and of main() per frame, with -f */
+	uint64_t awake_start;	/* host cycles, when firmware got control */
+	uint64_t overhead;	/* host cycles of empty measurement */
+	long isr[ISR_BINS];	/* host cycles of handler, no output */
+	long isr_bam[ISR_BINS];	/* and with output of BAM bit */
+	int frame_wake;		/* frame is due after this tick */
+	uint64_t *frame;	/* host cycles of main() after every frame tick,
+				   overhead is subtracted */
+	uint8_t *series;	/* levels[] after every frame */
+	uint8_t shown[CHANNELS];	/* levels[] in BAM buffer being shown */
+	uint8_t shown_buf;
+	enum sim_reg bam_reg[CHANNELS];	/* port and pin of BAM channel */
+	uint8_t bam_pin[CHANNELS];
+	uint64_t high[CHANNELS];	/* ticks with BAM pin high */
+	uint64_t expect[CHANNELS];	/* sum of shown values over ticks */
+	FILE *log;
+	jmp_buf done_jmp;
+} sim;
+
+static int cmp_u64(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+	return (x > y) - (x < y);
+}
+
+static void print_stats(const char *name, uint64_t min, uint64_t median,
+			double mean, uint64_t p99, uint64_t max)
+{
+	printf("%-16s min %6llu  median %6llu  mean %8.1f  p99 %6llu  max %8llu\n",
+	       name, (unsigned long long)min, (unsigned long long)median, mean,
+	       (unsigned long long)p99, (unsigned long long)max);
+}
+
+/**
+ * report() - print statistics of samples.
+ * @name:	what was measured.
+ * @samples:	cycles of every call. Are sorted.
+ * @num:	number of samples.
+ * @overhead:	cycles of empty measurement, subtracted.
+ */
+static void report(const char *name, uint64_t *samples, long num, uint64_t overhead)
+{
+	double mean = 0.;
+
+	qsort(samples, num, sizeof *samples, cmp_u64);
+	for (long i = 0; i < num; i++) {
+		samples[i] = samples[i] > overhead ? samples[i] - overhead : 0;
+		mean += samples[i];
+	}
+	mean /= num;
+	print_stats(name, samples[0], samples[num / 2], mean,
+		    samples[num * 99 / 100], samples[num - 1]);
+}
+
+/* report() of samples counted in ISR_BINS bins, which include overhead */
+static void report_bins(const char *name, const long *bins, uint64_t overhead)
+{
+	long num = 0, seen = 0;
+	uint64_t min = 0, median = 0, p99 = 0, max = 0;
+	double mean = 0.;
+
+	for (int b = 0; b < ISR_BINS; b++)
+		num += bins[b];
+	if (0 == num)
+		return;
+	for (int b = 0; b < ISR_BINS; b++) {
+		if (!bins[b])
+			continue;
+		uint64_t value = b > (int)overhead ? b - overhead : 0;
+		if (0 == seen)
+			min = value;
+		if (seen <= num / 2 && seen + bins[b] > num / 2)
+			median = value;
+		if (seen <= num * 99 / 100 && seen + bins[b] > num * 99 / 100)
+			p99 = value;
+		max = value;
+		seen += bins[b];
+		mean += (double)value * bins[b];
+	}
+	print_stats(name, min, median, mean / num, p99, max);
+}
+
+/* Logs touched registers and clears marks */
+static void log_writes(FILE *log, uint64_t cycle)
+{
+	for (int r = 0; r < SIM_REG_COUNT; r++) {
+		if (!sim_touched[r])
+			continue;
+		sim_touched[r] = 0;
+		if (log)
+			fprintf(log, "%llu,%s,%u\n", (unsigned long long)cycle,
+				_reg_names[r], sim_regs[r]);
+	}
+}
+
+/* Leaves firmware for good, ret is exit code of simulation */
+static void sim_stop(const char *why, int ret)
+{
+	if (why)
+		fprintf(stderr, "Frame %ld: %s\n", sim.done, why);
+	longjmp(sim.done_jmp, ret + 1);
+}
+
+/* Pins of BAM channels in order of firmware: ports B, C, D, low bits first */
+static void map_bam_pins(void)
+{
+	static const struct {
+		enum sim_reg reg;
+		uint8_t mask;
+	} ports[] = {
+		{SIM_PORTB, BAM_MASK_B}, {SIM_PORTC, BAM_MASK_C},
+		{SIM_PORTD, BAM_MASK_D}
+	};
+	int ch = HW_CHANNELS;
+
+	for (size_t p = 0; p < sizeof ports / sizeof *ports; p++)
+		for (int bit = 0; bit < 8; bit++)
+			if ((ports[p].mask & (1 << bit)) && ch < CHANNELS) {
+				sim.bam_reg[ch] = ports[p].reg;
+				sim.bam_pin[ch++] = 1 << bit;
+			}
+}
+
+/*
+ * sim_sleep() - sleep_cpu() of firmware. Only overflow of timer 1 wakes core
+ * up, firmware without it would sleep forever.
+ */
+void sim_sleep(void)
+{
+	uint64_t now = sim_cycles();
+	uint64_t main_cost = now - sim.awake_start;
+
+	main_cost = main_cost > sim.overhead ? main_cost - sim.overhead : 0;
+	if (sim.frame_wake) {
+		sim.frame_wake = 0;
+		sim.frame[sim.done] = main_cost;
+		memcpy(&sim.series[sim.done * CHANNELS], levels, CHANNELS);
+		for (int ch = 0; ch < HW_CHANNELS; ch++)
+			if (sim_regs[_hw_regs[ch]] != levels[ch])
+				sim_stop("compare register differs from level", 1);
+		sim.done++;
+	}
+	/* Writes of main() since the last wake-up, setup ones at reset */
+	log_writes(sim.log, sim.avr_time);
+	if (sim.done == sim.frames)
+		sim_stop(NULL, 0);
+
+	if (!(sim_regs[SIM_SMCR] & _BV(SE))) {
+		sim.awake_start = sim_cycles();
+		return;	/* sleep instruction does nothing */
+	}
+	if (!sim_sreg_i || !(sim_regs[SIM_TIMSK1] & _BV(TOIE1)))
+		sim_stop("sleeps with no wake-up interrupt enabled", 1);
+	unsigned prescaler = _t1_prescalers[sim_regs[SIM_TCCR1B] & 7];
+	unsigned mode = ((sim_regs[SIM_TCCR1B] >> WGM12) & 3) << 2
+			| (sim_regs[SIM_TCCR1A] & 3);
+	if (0 == prescaler || 0 == _t1_tops[mode])
+		sim_stop("timer 1 has no fixed TOP or no internal clock", 1);
+
+	/* Timer is never stopped, so wake-ups are a period apart */
+	sim.period = (uint64_t)prescaler * (_t1_tops[mode] + 1);
+	sim.avr_time += sim.period;
+	sim.ticks++;
+
+	uint64_t start = sim_cycles();
+	TIMER1_OVF_vect();
+	uint64_t cost = sim_cycles() - start;
+	int output = sim_touched[SIM_PORTB] | sim_touched[SIM_PORTC]
+		     | sim_touched[SIM_PORTD];
+	(output ? sim.isr_bam : sim.isr)[cost < ISR_BINS ? cost : ISR_BINS - 1]++;
+	sim.frame_wake = frame_due;
+
+	/* Buffer is filled from levels[] of the last frame */
+	if (bam_shown != sim.shown_buf) {
+		sim.shown_buf = bam_shown;
+		memcpy(sim.shown, &sim.series[(sim.done - 1) * CHANNELS], CHANNELS);
+	}
+	for (int ch = HW_CHANNELS; ch < CHANNELS; ch++) {
+		sim.high[ch] += !!(sim_regs[sim.bam_reg[ch]] & sim.bam_pin[ch]);
+		sim.expect[ch] += sim.shown[ch];
+	}
+
+	log_writes(sim.log, sim.avr_time);
+	/* Bookkeeping above is not firmware time */
+	sim.awake_start = sim_cycles();
+}
+
+/* Pearson correlation of levels of two channels over all frames */
+static double correlation(int a, int b)
+{
+	double sa = 0., sb = 0., saa = 0., sbb = 0., sab = 0.;
+	long n = sim.frames;
+
+	for (long f = 0; f < n; f++) {
+		double x = sim.series[f * CHANNELS + a];
+		double y = sim.series[f * CHANNELS + b];
+		sa += x;
+		sb += y;
+		saa += x * x;
+		sbb += y * y;
+		sab += x * y;
+	}
+	double cov = sab - sa * sb / n;
+	double var = (saa - sa * sa / n) * (sbb - sb * sb / n);
+	return var > 0. ? cov / sqrt(var) : 0.;
+}
+
+int main(int argc, char *argv[])
+{
+	const char *log_path = NULL;
+	int argopt, ret;
+
+	sim.frames = 2000;
+	while ((argopt = getopt(argc, argv, "hn:l:c:f:")) != -1) {
+		switch (argopt) {
+		case 'n':
+			sim.frames = atol(optarg);
+			break;
+		case 'l':
+			log_path = optarg;
+			break;
+		case 'c':
+			sim.isr_cycles = atol(optarg);
+			break;
+		case 'f':
+			sim.frame_cycles = atol(optarg);
+			break;
+		case 'h':
+		default:
+			printf("Usage: %s %s", argv[0], help_str);
+			exit('h' == argopt ? 0 : EXIT_FAILURE);
+		}
+	}
+	if (sim.frames < MIN_FRAMES) {
+		fprintf(stderr, "FRAMES has to be >= %d\n", MIN_FRAMES);
+		exit(EXIT_FAILURE);
+	}
+	if (sim.isr_cycles < 0 || sim.frame_cycles < 0) {
+		fprintf(stderr, "CYCLES can't be negative\n");
+		exit(EXIT_FAILURE);
+	}
+	if (NULL != log_path && NULL == (sim.log = fopen(log_path, "w"))) {
+		perror(log_path);
+		exit(EXIT_FAILURE);
+	}
+
+	uint64_t *samples = malloc(sim.frames * sizeof *samples);
+	sim.frame = malloc(sim.frames * sizeof *sim.frame);
+	sim.series = malloc(sim.frames * CHANNELS);
+	if (NULL == samples || NULL == sim.frame || NULL == sim.series) {
+		fprintf(stderr, "Failed to allocate memory\n");
+		exit(EXIT_FAILURE);
+	}
+	map_bam_pins();
+
+	/* Cost of measurement itself */
+	for (long i = 0; i < sim.frames; i++) {
+		uint64_t start = sim_cycles();
+		samples[i] = sim_cycles() - start;
+	}
+	qsort(samples, sim.frames, sizeof *samples, cmp_u64);
+	uint64_t overhead = sim.overhead = samples[0];
+
+	sim.awake_start = sim_cycles();
+	if (0 == (ret = setjmp(sim.done_jmp))) {
+		firmware_main();
+		sim_stop("firmware main() returned", 1);
+	}
+	if (--ret)
+		exit(ret);
+
+	unsigned mode = (sim_regs[SIM_SMCR] >> SM0) & 7;
+	double tick_rate = (double)F_CPU / sim.period;
+	printf("Channels: %d (%d hardware PWM, %d BAM), sleep mode: %s\n"
+	       "Tick every %llu AVR cycles (%.0f Hz), %.2f frames/s at F_CPU %lu Hz\n",
+	       CHANNELS, HW_CHANNELS, BAM_CHANNELS, _sleep_names[mode],
+	       (unsigned long long)sim.period, tick_rate,
+	       sim.frames * tick_rate / sim.ticks, (unsigned long)F_CPU);
+	if (BAM_CHANNELS)
+		printf("BAM cycle: 255 ticks, %.1f Hz\n", tick_rate / 255);
+	if (SLEEP_MODE_IDLE != mode)
+		printf("Warning: timers stop in this mode, so do PWM and wake-ups\n");
+
+	/* AVR side: wake-ups come from timer registers, cycles are stated */
+	printf("Budget: ISR has %llu AVR cycles per tick, frame() has %llu per frame\n",
+	       (unsigned long long)sim.period,
+	       (unsigned long long)(sim.period * sim.ticks / sim.frames));
+	if (sim.isr_cycles) {
+		double busy = (double)sim.isr_cycles * sim.ticks
+			      + (double)sim.frame_cycles * sim.frames;
+		printf("Awake: %.3f%% of time at %ld AVR cycles per wake-up and %ld "
+		       "per frame%s\n", busy * 100. / (sim.period * sim.ticks),
+		       sim.isr_cycles, sim.frame_cycles,
+		       sim.frame_cycles ? "" : " (frame() not counted, see -f)");
+	} else {
+		printf("Awake: pass AVR cycles per wake-up with -c, host cycles "
+		       "can't give share of time awake\n");
+	}
+
+	printf("Host cycles per call, relative only, not AVR timing "
+	       "(measurement overhead %llu subtracted):\n",
+	       (unsigned long long)overhead);
+	report_bins("ISR", sim.isr, overhead);
+	report_bins("ISR, BAM bit", sim.isr_bam, overhead);
+	report("frame()", sim.frame, sim.frames, 0);
+	printf("frame() per channel: %.1f host cycles (median)\n",
+	       (double)sim.frame[sim.frames / 2] / CHANNELS);
+
+	for (long i = 0; i < sim.frames; i++) {
+		uint64_t start = sim_cycles();
+		candle(0);
+		samples[i] = sim_cycles() - start;
+	}
+	report("candle()", samples, sim.frames, overhead);
+
+	uint16_t seed = 1;
+	for (long i = 0; i < sim.frames; i++) {
+		uint64_t start = sim_cycles();
+		xorshift16(&seed);
+		samples[i] = sim_cycles() - start;
+	}
+	report("xorshift16()", samples, sim.frames, overhead);
+
+	/* Partial BAM cycles at the ends only, error is near 0 */
+	double bam_error = 0.;
+	for (int ch = HW_CHANNELS; ch < CHANNELS; ch++) {
+		double error = fabs((double)sim.high[ch] / sim.ticks
+				    - (double)sim.expect[ch] / 255 / sim.ticks);
+		if (error > bam_error)
+			bam_error = error;
+	}
+	if (BAM_CHANNELS)
+		printf("BAM pins: duty differs from compare values by %.3f%% at most\n",
+		       bam_error * 100);
+
+	double max_r = 0., sum_r = 0.;
+	int pairs = 0;
+	for (int a = 0; a < CHANNELS; a++)
+		for (int b = a + 1; b < CHANNELS; b++, pairs++) {
+			double r = fabs(correlation(a, b));
+			sum_r += r;
+			if (r > max_r)
+				max_r = r;
+		}
+	if (pairs)
+		printf("Correlation of channels: |r| max %.3f, mean %.3f\n",
+		       max_r, sum_r / pairs);
+
+	/* Fast PWM, non-inverting: pin is high for OCRnx + 1 of 256 ticks */
+	long hist[256] = {0};
+	for (long i = 0; i < sim.frames * CHANNELS; i++)
+		hist[sim.series[i]]++;
+	printf("Duty-cycle histogram (compare value, duty, share of channel frames):\n");
+	for (int v = 0; v < 256; v++)
+		if (hist[v])
+			printf("%3d  %6.2f%%  %6.2f%%\n", v, (v + 1) * 100. / 256,
+			       hist[v] * 100. / (sim.frames * CHANNELS));
+
+	if (sim.log)
+		fclose(sim.log);
+	free(sim.series);
+	free(sim.frame);
+	free(samples);
+	return 0;
+}